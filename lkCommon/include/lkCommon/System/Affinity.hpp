@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace lkCommon {
+namespace System {
+namespace Affinity {
+
+/**
+ * Pins calling thread to a single logical processor.
+ *
+ * @p[in] cpuID ID of logical processor, as reported in Info::LogicalCPU::id.
+ *
+ * @return True if thread was pinned, false if OS refused to do so (ex. when
+ *         processor does not exist or is not available to current process).
+ */
+bool PinCurrentThread(uint32_t cpuID);
+
+/**
+ * Allows calling thread to run on any logical processor available to current
+ * process, reverting the effect of PinCurrentThread().
+ *
+ * @return True on success, false otherwise.
+ */
+bool UnpinCurrentThread();
+
+} // namespace Affinity
+} // namespace System
+} // namespace lkCommon
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdlib>
+#include <cstdint>
+#include <vector>
 
 
 namespace lkCommon {
@@ -8,12 +10,38 @@ namespace System {
 namespace Info {
 
 
+// Placement of a single logical processor in the system
+struct LogicalCPU
+{
+    uint32_t id;        // index used by OS to identify the processor
+    uint32_t core;      // ID of physical core, unique within a package
+    uint32_t package;   // ID of physical package (socket)
+    uint32_t numaNode;  // ID of NUMA node processor belongs to
+};
+
+using CPUTopology = std::vector<LogicalCPU>;
+
+
 // Acquires number of logical processors in the system
 size_t GetCPUCount();
 
 // Acquires size of single page in bytes
 size_t GetPageSize();
 
+// Acquires size of single huge page in bytes, or regular page size if system
+// does not support huge pages
+size_t GetHugePageSize();
+
+// Acquires placement of logical processors available to current process,
+// sorted by processor ID
+CPUTopology GetCPUTopology();
+
+// Acquires number of physical cores available to current process
+size_t GetPhysicalCoreCount();
+
+// Acquires number of NUMA nodes with processors available to current process
+size_t GetNUMANodeCount();
+
 
 } // namespace Info
 } // namespace System
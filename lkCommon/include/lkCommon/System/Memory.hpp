@@ -24,6 +24,37 @@ void* AlignedAlloc(size_t size, size_t alignment);
  */
 void AlignedFree(void* ptr);
 
+/**
+ * Maps memory block straight from the OS, bypassing the heap.
+ *
+ * @p[in] size      Size of memory to map. Must be a multiple of system's page size.
+ * @p[in] hugePages Back the block with huge pages, if @p size is big enough and system allows
+ *                  it. Regular pages are used otherwise.
+ *
+ * @return Pointer to zeroed, page-aligned memory, nullptr if mapping failed. Block backed by huge
+ *         pages is aligned to huge page size.
+ */
+void* MapMemory(size_t size, bool hugePages);
+
+/**
+ * Unmaps memory block acquired from MapMemory().
+ *
+ * @p[in] ptr  Block to unmap.
+ * @p[in] size Size of the block, same as passed to MapMemory().
+ */
+void UnmapMemory(void* ptr, size_t size);
+
+/**
+ * Gives physical memory backing a block back to the OS, keeping the block mapped.
+ *
+ * Contents of the block are lost - it reads as zeros afterwards, and memory is backed again only
+ * when it is touched.
+ *
+ * @p[in] ptr  Page-aligned beginning of the block.
+ * @p[in] size Size of the block. Must be a multiple of system's page size.
+ */
+void DiscardMemory(void* ptr, size_t size);
+
 } // namespace lkCommon
 } // namespace System
 } // namespace Memory
@@ -2,9 +2,13 @@
 
 #include "lkCommon/lkCommon.hpp"
 
+#include <array>
+#include <functional>
 #include <list>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <cstddef>
 
 
 namespace lkCommon {
@@ -14,8 +18,9 @@ struct Arena
 {
     uint8_t* ptr;
     size_t size;
-    size_t sizeLeft;
-    size_t referenceCount;
+    size_t sizeLeft; // guarded by allocator's mutex
+    // live allocations in the chunk, plus a large bias for each thread cache holding a region of it
+    std::atomic<size_t> referenceCount;
 
     Arena()
         : ptr(nullptr)
@@ -26,6 +31,155 @@ struct Arena
     }
 };
 
+/**
+ * Selects how ArenaAllocator reuses memory of freed allocations.
+ *
+ * DEFAULT reclaims freed memory only when all allocations of a chunk are freed. SMALL_OBJECTS
+ * additionally rounds small allocations up to one of segregated size classes and serves them
+ * from pages dedicated to a single class, so a freed block is reused right away by the next
+ * allocation of the same class. This bounds memory used by workloads which constantly allocate
+ * and free small objects, at the cost of some rounding waste.
+ */
+enum class ArenaAllocatorMode: unsigned char
+{
+    DEFAULT = 0,
+    SMALL_OBJECTS,
+};
+
+/**
+ * Selects where ArenaAllocator takes its chunks from.
+ *
+ * HEAP allocates chunks on the heap. MAPPED maps them straight from the OS, so memory of every
+ * released chunk goes back to the system and ClearUnusedChunks() can give back physical memory of
+ * the active chunk as well. MAPPED_HUGE_PAGES additionally backs chunks of at least a huge page
+ * with huge pages when system allows it, which greatly reduces TLB misses on big arenas.
+ */
+enum class ArenaChunkSource: unsigned char
+{
+    HEAP = 0,
+    MAPPED,
+    MAPPED_HUGE_PAGES,
+};
+
+/**
+ * Called when ArenaAllocator cannot add a chunk without exceeding its memory budget.
+ *
+ * @p[in] requestedSize Size of the smallest chunk which would satisfy the allocation.
+ * @p[in] usedSize      Total size of chunks allocator holds.
+ *
+ * Callback is called with allocator locked, so it must not use the allocator.
+ */
+using ArenaBudgetExceededCallback = std::function<void(size_t requestedSize, size_t usedSize)>;
+
+/**
+ * Describes how ArenaAllocator sizes its chunks and how much memory it can use.
+ *
+ * First chunk is @p initialChunkSize big, every following one is @p growthFactor times bigger
+ * than the previous, up to @p maxChunkSize. Allocation not fitting in a chunk of current size gets
+ * a chunk of its own size instead.
+ *
+ * Total size of all chunks never exceeds @p memoryBudget. When a new chunk would exceed it,
+ * allocator first frees unused chunks, then falls back to the smallest chunk fitting the
+ * allocation. If even that does not fit, @p budgetExceededCallback is called and the allocation
+ * fails.
+ *
+ * Zero sizes mean defaults: system's page size for @p initialChunkSize and no limit for
+ * @p maxChunkSize and @p memoryBudget.
+ */
+struct ArenaGrowthPolicy
+{
+    static const size_t NO_LIMIT = 0;
+    static constexpr float DEFAULT_GROWTH_FACTOR = 2.0f;
+
+    size_t initialChunkSize;
+    float growthFactor;
+    size_t maxChunkSize;
+    size_t memoryBudget;
+    ArenaBudgetExceededCallback budgetExceededCallback;
+
+    ArenaGrowthPolicy()
+        : initialChunkSize(0)
+        , growthFactor(DEFAULT_GROWTH_FACTOR)
+        , maxChunkSize(NO_LIMIT)
+        , memoryBudget(NO_LIMIT)
+        , budgetExceededCallback()
+    {
+    }
+};
+
+namespace Impl {
+
+class ArenaThreadCacheRegistry;
+
+// size classes used in ArenaAllocatorMode::SMALL_OBJECTS are multiples of granularity
+const size_t ARENA_SIZE_CLASS_GRANULARITY = 16;
+const size_t ARENA_SIZE_CLASS_COUNT = 16;
+
+/**
+ * Intrusive list of freed blocks of a single size class.
+ */
+struct ArenaFreeList
+{
+    uint8_t* head;
+    size_t count;
+
+    ArenaFreeList()
+        : head(nullptr)
+        , count(0)
+    {
+    }
+};
+
+/**
+ * Blocks of a single size class available to a thread without locking.
+ */
+struct ArenaSizeClassCache
+{
+    ArenaFreeList freeList;
+    uint8_t* runCurrent;        // next never used block in page dedicated to this size class
+    uint8_t* runEnd;            // end of the page
+
+    ArenaSizeClassCache()
+        : freeList()
+        , runCurrent(nullptr)
+        , runEnd(nullptr)
+    {
+    }
+};
+
+/**
+ * Part of a chunk reserved for a single thread, from which the thread allocates without locking.
+ *
+ * Cache is owned by ArenaAllocator, but its fields are touched only by the thread it belongs to.
+ */
+struct ArenaThreadCache
+{
+    Arena* arena;               // chunk current region was taken from, nullptr if there is no region
+    uint8_t* current;           // first free byte of the region
+    uint8_t* end;               // end of the region
+    uint8_t* lastAllocation;    // most recent allocation, can be given back right away when freed
+    uint8_t* lastAllocationStart; // value of current before most recent allocation and its padding
+    size_t allocationCount;     // allocations from region not yet added to arena's reference count
+    uint32_t generation;        // allocator's generation the region was taken in
+    std::array<ArenaSizeClassCache, ARENA_SIZE_CLASS_COUNT> sizeClasses;
+    uint32_t sizeClassGeneration; // allocator's generation blocks in sizeClasses come from
+
+    ArenaThreadCache()
+        : arena(nullptr)
+        , current(nullptr)
+        , end(nullptr)
+        , lastAllocation(nullptr)
+        , lastAllocationStart(nullptr)
+        , allocationCount(0)
+        , generation(0)
+        , sizeClasses()
+        , sizeClassGeneration(0)
+    {
+    }
+};
+
+} // namespace Impl
+
 /**
  * Allocates chunks of memory in system and provides interface to allocate data on it.
  *
@@ -34,12 +188,24 @@ struct Arena
  * number of system memory allocation calls is greatly reduced, which should result in speedup.
  *
  * At first Allocate() call, ArenaAllocator allocates one chunk of memory of @p mChunkSize size. If,
- * after numerous Allocate() calls there's not enough space, mChunkSize is increased by single page
- * size and new chunk is added to collection.
+ * after numerous Allocate() calls there's not enough space, mChunkSize is increased according to
+ * ArenaGrowthPolicy and new chunk is added to collection. Growth policy can also cap total memory
+ * used by the allocator.
  *
  * It is assumed that objects in ArenaAllocator can be singularly freed, however this will only
  * decrease reference counter for given chunk. Such memory won't be possible to reclaim,
  *
+ * Small allocations do not take allocator's mutex. Each thread reserves a region of current
+ * chunk for itself and serves allocations from it until it runs out, only then the mutex is taken
+ * to reserve next region. Chunk which has a region reserved by a thread is not reused, even if all
+ * its allocations were freed, until the thread moves on to another region or exits.
+ *
+ * Allocator created with ArenaAllocatorMode::SMALL_OBJECTS serves allocations of up to 256 bytes
+ * from size classes instead. Freed blocks go to a free list of calling thread and are reused by
+ * its next allocation of the same size class; lists growing too long are moved to allocator, where
+ * other threads can take them from. Pages dedicated to size classes are never given back to their
+ * chunk, so such chunks are released only by FreeChunks.
+ *
  * If need occurs, all used memory can be freed by FreeChunks function. This will automatically
  * invalidate all existing objects, so handle with care.
  *
@@ -51,22 +217,65 @@ struct Arena
  */
 class ArenaAllocator
 {
+    friend class Impl::ArenaThreadCacheRegistry;
+
     using ArenaCollection = std::list<Arena>;
+    using ThreadCacheCollection = std::list<Impl::ArenaThreadCache>;
+    using FreeListCollection = std::array<Impl::ArenaFreeList, Impl::ARENA_SIZE_CLASS_COUNT>;
 
+    uint64_t mID; // unique through process' lifetime, identifies allocator in thread-local data
+    ArenaAllocatorMode mMode;
+    ArenaChunkSource mChunkSource;
     size_t mPageSize;
+    size_t mHugePageSize;
+    ArenaGrowthPolicy mGrowthPolicy;
     size_t mArenaSize;
+    size_t mTotalChunkSize; // guarded by mutex
+    size_t mThreadCacheRegionSize;
+    size_t mMaxThreadCacheAllocationSize;
     ArenaCollection mArenas;
+    ThreadCacheCollection mThreadCaches;
+    FreeListCollection mSharedFreeLists; // blocks moved out of thread caches, guarded by mutex
+    // bumped by FreeChunks(), invalidates regions held by thread caches
+    std::atomic<uint32_t> mGeneration;
     std::mutex mAllocatorMutex;
 
-    Arena* AddChunk();
-    Arena* FindFreeArena(size_t size);
+    size_t RoundChunkSize(size_t size) const;
+    size_t GetInitialChunkSize() const;
+    size_t GetGrownChunkSize(size_t size) const;
+    size_t GrowChunkSizeToFit(size_t chunkSize, size_t size) const;
+    Arena* AddChunk(size_t size, size_t minSize);
+    void FreeChunkMemory(uint8_t* memory, size_t size);
+    void FreeChunk(Arena& arena);
+    void FreeUnusedChunks();
     Arena* FindArenaByPointer(void* ptr);
+    Arena* ReserveChunkSpace(size_t size, size_t alignment);
+    void* AllocateFromChunk(size_t size, size_t alignment);
+    Impl::ArenaThreadCache* GetThreadCache();
+    void* AllocateFromNewRegion(Impl::ArenaThreadCache& cache, size_t size, size_t alignment);
+    void ReleaseRegion(Impl::ArenaThreadCache& cache);
+    void ReleaseThreadCache(Impl::ArenaThreadCache& cache);
+    void ReuseIfUnused(Arena& arena);
+    void* AllocateFromSizeClass(size_t sizeClass);
+    void* RefillSizeClass(Impl::ArenaThreadCache& cache, size_t sizeClass);
+    void FreeToSizeClass(void* ptr, size_t sizeClass);
+    void ResetSizeClasses(Impl::ArenaThreadCache& cache);
+    void ReleaseSizeClasses(Impl::ArenaThreadCache& cache);
 
 public:
+    /**
+     * Biggest alignment Allocate(size_t) can choose on its own, enough for any scalar type.
+     */
+    static const size_t DEFAULT_ALIGNMENT = alignof(std::max_align_t);
+
     /**
      * Create an ArenaAllocator with default chunk size equal to system's page size.
+     *
+     * @p[in] mode        Selects how memory of freed allocations is reused.
+     * @p[in] chunkSource Selects where chunks are taken from.
      */
-    ArenaAllocator();
+    explicit ArenaAllocator(ArenaAllocatorMode mode = ArenaAllocatorMode::DEFAULT,
+                            ArenaChunkSource chunkSource = ArenaChunkSource::HEAP);
 
     /**
      * Destroy an ArenaAllocator. All chunks will be freed, which also frees all allocated memory.
@@ -92,23 +301,58 @@ public:
      *   - Size of allocated data exceeds current chunk size
      *
      * In such case, all currently allocated blocks remain in old chunk and all future allocations
-     * will be directed to new chunk with doubled size.
+     * will be directed to new chunk, grown according to ArenaGrowthPolicy (by default doubled).
      *
      * For best performance, allocated chunks should have way smaller size than chunk size. If
      * there will be an allocation of size higher than current chunk size, Allocator will increase
      * the chunk size to fit an object of given size, plus padding necessary to align to page size.
      *
-     * This call is thread-safe.
+     * Returns nullptr if a chunk could not be added, ex. because of ArenaGrowthPolicy's budget.
+     *
+     * This call is thread-safe. Allocations of up to a quarter of system's page size are served
+     * from calling thread's cache and do not lock the allocator.
+     *
+     * Returned memory is aligned to the biggest power of two dividing @p size, but not bigger than
+     * DEFAULT_ALIGNMENT - so arrays of any type are aligned to their element's alignment, while
+     * odd-sized allocations do not waste space on padding.
+     *
+     * In ArenaAllocatorMode::SMALL_OBJECTS, allocations of up to 256 bytes are rounded up to a
+     * multiple of 16 bytes and come from size classes.
      */
     void* Allocate(size_t size);
 
+    /**
+     * Allocate data of size @p size aligned to @p alignment and return pointer to it.
+     *
+     * @p[in] size      Size of memory to allocate in the arena in bytes.
+     * @p[in] alignment Required alignment of returned pointer in bytes. Must be a power of two.
+     *
+     * Works the same as Allocate(size_t), but skips as many bytes as needed to align the
+     * allocation. Use for types requiring stricter alignment than their size implies, ex. to
+     * safely use aligned SIMD loads on allocated data.
+     *
+     * In ArenaAllocatorMode::SMALL_OBJECTS, @p size is rounded up to a multiple of @p alignment
+     * instead, if that is bigger than 16 bytes - size class is used if the result still fits in
+     * 256 bytes.
+     */
+    void* Allocate(size_t size, size_t alignment);
+
     /**
      * Free pointer from Arena.
      *
      * @p ptr Pointer to object to free.
      *
      * This function will find chunk to which pointer belongs and decrease allocated object count
-     * at that chunk. If chunk has zero allocations, it will be marked for reuse.
+     * at that chunk. If chunk has zero allocations, its space will be reused next time allocator
+     * reaches for it. Freeing the most recent allocation of calling thread gives its memory back
+     * right away.
+     *
+     * Chunk is found in constant time, regardless of how many chunks the allocator has. This call
+     * does not lock the allocator.
+     *
+     * In ArenaAllocatorMode::SMALL_OBJECTS, block allocated from a size class is put on calling
+     * thread's free list instead and is reused by next allocation of the same size class. Allocator
+     * is locked only when the list grows long enough to be shared with other threads.
      */
     void Free(void* ptr);
 
@@ -118,7 +362,9 @@ public:
      * It is caller's duty to ensure that all data will not be used after this point.
      *
      * After this call object is still usable and Allocate() can be called again for
-     * new chunk allocation.
+     * new chunk allocation. Regions reserved by thread caches are dropped as well.
+     *
+     * @warning This function must not be called while other threads allocate from the allocator.
      */
     void FreeChunks();
 
@@ -126,23 +372,54 @@ public:
      * Goes through all allocated chunks and clears chunks whose reference count is equal to zero
      * (not counting last chunk, aka. currently active chunk).
      *
-     * If there's only one chunk, function does nothing.
+     * Region reserved by calling thread's cache is released first, so chunks used only by
+     * calling thread can be cleared. Chunks with regions reserved by other threads are kept.
+     *
+     * With mapped chunks, physical memory of the active chunk is given back to the system as well,
+     * if the chunk is unused. Its address range stays reserved for following allocations.
+     *
+     * Other than that, if there's only one chunk, function does nothing.
      */
     void ClearUnusedChunks();
 
+    /**
+     * Changes how following chunks are sized and how much memory allocator can use.
+     *
+     * @p[in] policy New growth policy.
+     *
+     * Chunks allocated so far are kept, even if they exceed new limits. Initial chunk size is used
+     * when allocator has no chunks, ex. before first allocation or after FreeChunks().
+     */
+    void SetGrowthPolicy(const ArenaGrowthPolicy& policy);
+
+    /**
+     * Returns current growth policy.
+     */
+    ArenaGrowthPolicy GetGrowthPolicy();
+
     /**
      * Returns free space in currently active chunk of data.
      *
      * @warning This function is for test purposes only. In real life scenarios, ArenaAllocator
      *          will add new chunks when needed. As a result, this function does NOT reflect total
      *          free space available for use.
+     *
+     * Space left in calling thread's cache region is included, if the region belongs to currently
+     * active chunk.
+     */
+    size_t GetFreeChunkSpace() const;
+
+    /**
+     * Returns the biggest power of two dividing @p size, but not bigger than @p maxAlignment.
+     *
+     * Size of a type is always a multiple of its alignment, so memory aligned this way is always
+     * properly aligned for an object (or array of objects) of given size, as long as type's
+     * alignment does not exceed @p maxAlignment.
      */
-    LKCOMMON_INLINE size_t GetFreeChunkSpace() const
+    static constexpr size_t GetNaturalAlignment(size_t size, size_t maxAlignment)
     {
-        if (mArenas.empty())
-            return mArenaSize;
-        else
-            return mArenas.back().sizeLeft;
+        return ((size & (~size + 1)) == 0 || (size & (~size + 1)) > maxAlignment) ?
+                maxAlignment : (size & (~size + 1));
     }
 
     /**
@@ -156,6 +433,17 @@ public:
     {
         return mArenas.size();
     }
+
+    /**
+     * Returns total size of allocated chunks, which is what counts against memory budget.
+     *
+     * @warning This function is for test purposes only. Value is read without locking the
+     *          allocator.
+     */
+    LKCOMMON_INLINE size_t GetTotalChunkSize() const
+    {
+        return mTotalChunkSize;
+    }
 };
 
 } // namespace Utils
@@ -3,26 +3,52 @@
 #include "lkCommon/Utils/ArenaAllocator.hpp"
 #include <cstring>
 #include <memory>
+#include <new>
 
 
 namespace lkCommon {
 namespace Utils {
 
+/**
+ * Base class making derived objects allocable with ArenaAllocator, ex. new (allocator) Object().
+ *
+ * Objects are aligned to the biggest power of two dividing their size, up to MAX_ALIGNMENT.
+ * Size of a type is always a multiple of its alignment, so this honours alignof() of any
+ * derived type, including SIMD types like Vector4, without knowing the type itself. Types
+ * aligned to more than MAX_ALIGNMENT are handled exactly by C++17 aligned new, when available.
+ */
 class ArenaObject
 {
     static void* operator new(size_t size) { return malloc(size); };
     static void operator delete(void* p) { free(p); };
 
 public:
+    /**
+     * Biggest alignment chosen from object's size.
+     */
+    static const size_t MAX_ALIGNMENT = 64;
+
     static void* operator new(size_t size, ArenaAllocator& allocator)
     {
-        return allocator.Allocate(size);
+        return allocator.Allocate(size, ArenaAllocator::GetNaturalAlignment(size, MAX_ALIGNMENT));
     }
 
     static void operator delete(void* p, ArenaAllocator& allocator)
     {
         allocator.Free(p);
     }
+
+#ifdef __cpp_aligned_new
+    static void* operator new(size_t size, std::align_val_t alignment, ArenaAllocator& allocator)
+    {
+        return allocator.Allocate(size, static_cast<size_t>(alignment));
+    }
+
+    static void operator delete(void* p, std::align_val_t, ArenaAllocator& allocator)
+    {
+        allocator.Free(p);
+    }
+#endif // __cpp_aligned_new
 };
 
 } // namespace lkCommon
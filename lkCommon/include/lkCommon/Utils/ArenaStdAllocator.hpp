@@ -0,0 +1,172 @@
+#pragma once
+
+#include "lkCommon/lkCommon.hpp"
+#include "lkCommon/Utils/ArenaAllocator.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+
+
+namespace lkCommon {
+namespace Utils {
+
+/**
+ * Adapter satisfying standard Allocator requirements, making STL containers take memory from an
+ * ArenaAllocator, ex. std::vector<int, ArenaStdAllocator<int>> v(ArenaStdAllocator<int>(arena)).
+ *
+ * Adapter only refers to the ArenaAllocator, which has to outlive all containers using it. Copies
+ * of the adapter, including ones rebound to other types, use the same ArenaAllocator and compare
+ * equal. Moving and swapping containers carries the adapter along, so memory is always freed
+ * through the ArenaAllocator it was taken from.
+ *
+ * Containers can also be dropped all at once by ArenaAllocator::FreeChunks(), as long as they
+ * are never touched afterwards - including their destructors.
+ */
+template <typename T>
+class ArenaStdAllocator
+{
+    template <typename U>
+    friend class ArenaStdAllocator;
+
+    ArenaAllocator* mAllocator;
+
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = ArenaStdAllocator<U>;
+    };
+
+    /**
+     * Create an adapter taking memory from @p allocator.
+     */
+    explicit ArenaStdAllocator(ArenaAllocator& allocator) noexcept
+        : mAllocator(&allocator)
+    {
+    }
+
+    template <typename U>
+    ArenaStdAllocator(const ArenaStdAllocator<U>& other) noexcept
+        : mAllocator(other.mAllocator)
+    {
+    }
+
+    /**
+     * Allocate memory for @p count objects of type T.
+     *
+     * @note As required from standard allocators, std::bad_alloc is thrown if ArenaAllocator
+     *       fails to provide the memory.
+     */
+    T* allocate(size_t count)
+    {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_alloc();
+        }
+
+        void* ptr = mAllocator->Allocate(count * sizeof(T), alignof(T));
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        return reinterpret_cast<T*>(ptr);
+    }
+
+    /**
+     * Free memory acquired from allocate().
+     */
+    void deallocate(T* ptr, size_t) noexcept
+    {
+        mAllocator->Free(ptr);
+    }
+
+    /**
+     * Returns ArenaAllocator used by the adapter.
+     */
+    LKCOMMON_INLINE ArenaAllocator& GetArenaAllocator() const
+    {
+        return *mAllocator;
+    }
+
+    template <typename U>
+    bool operator==(const ArenaStdAllocator<U>& other) const noexcept
+    {
+        return mAllocator == other.mAllocator;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaStdAllocator<U>& other) const noexcept
+    {
+        return mAllocator != other.mAllocator;
+    }
+};
+
+#ifdef __cpp_lib_memory_resource
+
+/**
+ * Polymorphic memory resource taking memory from an ArenaAllocator, for use with std::pmr
+ * containers. Available only when compiling with C++17 library support.
+ *
+ * ArenaAllocator has to outlive the resource and all containers using it.
+ */
+class ArenaMemoryResource: public std::pmr::memory_resource
+{
+    ArenaAllocator& mAllocator;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        void* ptr = mAllocator.Allocate(bytes, alignment);
+        if (ptr == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t, size_t) override
+    {
+        mAllocator.Free(ptr);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        const ArenaMemoryResource* otherArena = dynamic_cast<const ArenaMemoryResource*>(&other);
+        return otherArena != nullptr && &otherArena->mAllocator == &mAllocator;
+    }
+
+public:
+    /**
+     * Create a resource taking memory from @p allocator.
+     */
+    explicit ArenaMemoryResource(ArenaAllocator& allocator) noexcept
+        : mAllocator(allocator)
+    {
+    }
+
+    /**
+     * Returns ArenaAllocator used by the resource.
+     */
+    LKCOMMON_INLINE ArenaAllocator& GetArenaAllocator() const
+    {
+        return mAllocator;
+    }
+};
+
+#endif // __cpp_lib_memory_resource
+
+} // namespace Utils
+} // namespace lkCommon
@@ -0,0 +1,235 @@
+/**
+ * @file
+ * @author LKostyra (costyrra.xl@gmail.com)
+ * @brief  Coroutine-based asynchronous tasks executed on ThreadPool
+ */
+
+#pragma once
+#define _LKCOMMON_UTILS_ASYNC_TASK_HPP_
+
+#include <lkCommon/Utils/ThreadPool.hpp>
+
+// Coroutines require C++20 - library itself does not depend on them, so this
+// module is available only to users compiling their code with C++20 support
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define LKCOMMON_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef LKCOMMON_HAS_COROUTINES
+#define LKCOMMON_HAS_COROUTINES 0
+#endif
+
+#if LKCOMMON_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+
+
+namespace lkCommon {
+namespace Utils {
+
+template <typename T>
+class AsyncTask;
+
+namespace Impl {
+
+// Resumes coroutine which awaits finished AsyncTask, if there is any
+struct AsyncTaskFinalAwaiter
+{
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept;
+
+    void await_resume() noexcept
+    {
+    }
+};
+
+struct AsyncTaskPromiseBase
+{
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    AsyncTaskFinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        exception = std::current_exception();
+    }
+};
+
+template <typename T>
+struct AsyncTaskPromise: public AsyncTaskPromiseBase
+{
+    std::optional<T> result;
+
+    AsyncTask<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value);
+
+    T& GetResult();
+};
+
+template <>
+struct AsyncTaskPromise<void>: public AsyncTaskPromiseBase
+{
+    AsyncTask<void> get_return_object() noexcept;
+
+    void return_void() noexcept
+    {
+    }
+
+    void GetResult();
+};
+
+// Notifies thread blocked in SyncWait() that awaited task finished
+struct SyncWaitLatch
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    void Set();
+    void Wait();
+};
+
+} // namespace Impl
+
+/**
+ * Coroutine returning a value of type @p T, which can be awaited by other
+ * coroutines.
+ *
+ * To create an AsyncTask, write a coroutine function returning AsyncTask<T>
+ * and use co_return to provide the result. AsyncTask is lazy - coroutine does
+ * not start until it is awaited with co_await or passed to SyncWait(). Awaiting
+ * coroutine is suspended and resumed on the thread which finished the task,
+ * without blocking any thread in the meantime.
+ *
+ * AsyncTask does not pick a thread on its own - use co_await ScheduleOn() to
+ * move execution of coroutine to ThreadPool's worker thread, or co_await
+ * RunAsync() to offload a callback to the Pool.
+ *
+ * Example:
+ * @code
+ * AsyncTask<Image> LoadImage(ThreadPool& pool, std::string path)
+ * {
+ *     co_await ScheduleOn(pool);
+ *     Image image;
+ *     image.Load(path);
+ *     co_return image;
+ * }
+ * @endcode
+ *
+ * AsyncTask is move-only. Destroying it destroys the coroutine, so it must not
+ * be destroyed while it is running.
+ *
+ * @note Available only when compiling with C++20 coroutine support, which is
+ *       signalled by LKCOMMON_HAS_COROUTINES macro being equal to 1.
+ */
+template <typename T = void>
+class AsyncTask
+{
+public:
+    using promise_type = Impl::AsyncTaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+private:
+    Handle mHandle;
+
+public:
+    class Awaiter;
+
+    AsyncTask();
+    explicit AsyncTask(Handle handle);
+    ~AsyncTask();
+
+    AsyncTask(const AsyncTask&) = delete;
+    AsyncTask& operator=(const AsyncTask&) = delete;
+    AsyncTask(AsyncTask&& other) noexcept;
+    AsyncTask& operator=(AsyncTask&& other) noexcept;
+
+    /**
+     * Returns true if AsyncTask is associated with a coroutine.
+     */
+    bool IsValid() const;
+
+    /**
+     * Returns true if coroutine finished and its result is ready.
+     */
+    bool IsDone() const;
+
+    /**
+     * Starts the coroutine (if needed) and suspends awaiting coroutine until
+     * the result is available. Result is moved out of the task.
+     */
+    Awaiter operator co_await() && noexcept;
+};
+
+/**
+ * Awaitable which moves execution of awaiting coroutine to @p pool's worker
+ * thread.
+ *
+ * @p[in] pool     Thread Pool which will resume the coroutine.
+ * @p[in] priority Priority of the task resuming the coroutine.
+ * @result Awaitable, which returns ThreadPayload of the worker thread
+ *         which resumed the coroutine.
+ *
+ * Awaiting coroutine is suspended and resumed by a Pool's task, so the thread
+ * which called co_await is free to do other work right away.
+ */
+inline auto ScheduleOn(ThreadPool& pool, TaskPriority priority = TaskPriority::NORMAL);
+
+/**
+ * Awaitable which executes @p callback as @p pool's task and resumes awaiting
+ * coroutine on the worker thread which executed it.
+ *
+ * @p[in] pool     Thread Pool to execute @p callback on.
+ * @p[in] callback Callback to execute. Must be callable as
+ *                 callback(ThreadPayload&). Callback is moved by this
+ *                 function.
+ * @p[in] priority Priority of the task.
+ * @result Awaitable, which returns value returned by @p callback.
+ */
+template <typename Callback>
+auto RunAsync(ThreadPool& pool, Callback&& callback, TaskPriority priority = TaskPriority::NORMAL);
+
+/**
+ * Starts @p task and blocks calling thread until it finishes.
+ *
+ * @p[in] task Task to run. Task is moved by this function.
+ * @result Value returned by @p task's coroutine.
+ *
+ * Use this function to bridge regular code with coroutines, ex. to run the
+ * top-level coroutine from the main thread.
+ *
+ * @warning Blocking a Pool's worker thread this way while coroutines are
+ *          scheduled on the same Pool might lead to a deadlock. Inside of
+ *          coroutines use co_await instead.
+ */
+template <typename T>
+T SyncWait(AsyncTask<T>&& task);
+
+} // namespace Utils
+} // namespace lkCommon
+
+#include "AsyncTaskImpl.hpp"
+
+#endif // LKCOMMON_HAS_COROUTINES
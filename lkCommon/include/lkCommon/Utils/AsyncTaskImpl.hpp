@@ -0,0 +1,405 @@
+/**
+ * @file
+ * @author LKostyra (costyrra.xl@gmail.com)
+ * @brief  Coroutine-based asynchronous tasks template definitions
+ */
+
+#pragma once
+
+#ifndef _LKCOMMON_UTILS_ASYNC_TASK_HPP_
+#error "Please include main header of AsyncTask, not the implementation header."
+#endif // _LKCOMMON_UTILS_ASYNC_TASK_HPP_
+
+
+namespace lkCommon {
+namespace Utils {
+namespace Impl {
+
+template <typename Promise>
+std::coroutine_handle<> AsyncTaskFinalAwaiter::await_suspend(std::coroutine_handle<Promise> handle) noexcept
+{
+    // symmetric transfer - awaiting coroutine continues on this thread
+    // without growing the stack
+    std::coroutine_handle<> continuation = handle.promise().continuation;
+    if (continuation)
+    {
+        return continuation;
+    }
+
+    return std::noop_coroutine();
+}
+
+template <typename T>
+AsyncTask<T> AsyncTaskPromise<T>::get_return_object() noexcept
+{
+    return AsyncTask<T>(std::coroutine_handle<AsyncTaskPromise<T>>::from_promise(*this));
+}
+
+template <typename T>
+template <typename U>
+void AsyncTaskPromise<T>::return_value(U&& value)
+{
+    result.emplace(std::forward<U>(value));
+}
+
+template <typename T>
+T& AsyncTaskPromise<T>::GetResult()
+{
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+
+    return *result;
+}
+
+inline AsyncTask<void> AsyncTaskPromise<void>::get_return_object() noexcept
+{
+    return AsyncTask<void>(std::coroutine_handle<AsyncTaskPromise<void>>::from_promise(*this));
+}
+
+inline void AsyncTaskPromise<void>::GetResult()
+{
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+inline void SyncWaitLatch::Set()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cv.notify_all();
+}
+
+inline void SyncWaitLatch::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() {
+        return done;
+    });
+}
+
+} // namespace Impl
+
+
+template <typename T>
+class AsyncTask<T>::Awaiter
+{
+    Handle mHandle;
+
+public:
+    explicit Awaiter(Handle handle)
+        : mHandle(handle)
+    {
+    }
+
+    bool await_ready() noexcept
+    {
+        return !mHandle || mHandle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        mHandle.promise().continuation = awaiting;
+        return mHandle;
+    }
+
+    T await_resume()
+    {
+        if constexpr (std::is_void<T>::value)
+        {
+            mHandle.promise().GetResult();
+        }
+        else
+        {
+            return std::move(mHandle.promise().GetResult());
+        }
+    }
+};
+
+template <typename T>
+AsyncTask<T>::AsyncTask()
+    : mHandle()
+{
+}
+
+template <typename T>
+AsyncTask<T>::AsyncTask(Handle handle)
+    : mHandle(handle)
+{
+}
+
+template <typename T>
+AsyncTask<T>::~AsyncTask()
+{
+    if (mHandle)
+    {
+        mHandle.destroy();
+    }
+}
+
+template <typename T>
+AsyncTask<T>::AsyncTask(AsyncTask&& other) noexcept
+    : mHandle(other.mHandle)
+{
+    other.mHandle = nullptr;
+}
+
+template <typename T>
+AsyncTask<T>& AsyncTask<T>::operator=(AsyncTask&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (mHandle)
+        {
+            mHandle.destroy();
+        }
+
+        mHandle = other.mHandle;
+        other.mHandle = nullptr;
+    }
+
+    return *this;
+}
+
+template <typename T>
+bool AsyncTask<T>::IsValid() const
+{
+    return static_cast<bool>(mHandle);
+}
+
+template <typename T>
+bool AsyncTask<T>::IsDone() const
+{
+    LKCOMMON_ASSERT(IsValid(), "AsyncTask is not associated with any coroutine");
+    return mHandle.done();
+}
+
+template <typename T>
+typename AsyncTask<T>::Awaiter AsyncTask<T>::operator co_await() && noexcept
+{
+    return Awaiter(mHandle);
+}
+
+
+namespace Impl {
+
+// Eagerly started coroutine which destroys itself when finished
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        DetachedCoroutine get_return_object() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+template <typename T>
+DetachedCoroutine SyncWaitCoroutine(AsyncTask<T>& task, std::optional<T>& result,
+                                    std::exception_ptr& exception, SyncWaitLatch& latch)
+{
+    try
+    {
+        result.emplace(co_await std::move(task));
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+
+    latch.Set();
+}
+
+inline DetachedCoroutine SyncWaitCoroutine(AsyncTask<void>& task, std::exception_ptr& exception,
+                                           SyncWaitLatch& latch)
+{
+    try
+    {
+        co_await std::move(task);
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+
+    latch.Set();
+}
+
+// Awaiter resuming coroutine from inside of a ThreadPool's task
+class ScheduleAwaiter
+{
+    ThreadPool& mPool;
+    TaskPriority mPriority;
+    ThreadPayload* mPayload;
+
+public:
+    ScheduleAwaiter(ThreadPool& pool, TaskPriority priority)
+        : mPool(pool)
+        , mPriority(priority)
+        , mPayload(nullptr)
+    {
+    }
+
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        // awaiter lives in coroutine's frame, which is kept until resume
+        mPool.AddTask([this, handle](ThreadPayload& payload) {
+            mPayload = &payload;
+            handle.resume();
+        }, mPriority);
+    }
+
+    ThreadPayload& await_resume() noexcept
+    {
+        return *mPayload;
+    }
+};
+
+template <typename Callback, typename Result>
+class RunAsyncAwaiter
+{
+    ThreadPool& mPool;
+    TaskPriority mPriority;
+    Callback mCallback;
+    std::optional<Result> mResult;
+
+public:
+    RunAsyncAwaiter(ThreadPool& pool, Callback&& callback, TaskPriority priority)
+        : mPool(pool)
+        , mPriority(priority)
+        , mCallback(std::move(callback))
+        , mResult()
+    {
+    }
+
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        mPool.AddTask([this, handle](ThreadPayload& payload) {
+            mResult.emplace(mCallback(payload));
+            handle.resume();
+        }, mPriority);
+    }
+
+    Result await_resume()
+    {
+        return std::move(*mResult);
+    }
+};
+
+template <typename Callback>
+class RunAsyncAwaiter<Callback, void>
+{
+    ThreadPool& mPool;
+    TaskPriority mPriority;
+    Callback mCallback;
+
+public:
+    RunAsyncAwaiter(ThreadPool& pool, Callback&& callback, TaskPriority priority)
+        : mPool(pool)
+        , mPriority(priority)
+        , mCallback(std::move(callback))
+    {
+    }
+
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        mPool.AddTask([this, handle](ThreadPayload& payload) {
+            mCallback(payload);
+            handle.resume();
+        }, mPriority);
+    }
+
+    void await_resume() noexcept
+    {
+    }
+};
+
+} // namespace Impl
+
+
+inline auto ScheduleOn(ThreadPool& pool, TaskPriority priority)
+{
+    return Impl::ScheduleAwaiter(pool, priority);
+}
+
+template <typename Callback>
+auto RunAsync(ThreadPool& pool, Callback&& callback, TaskPriority priority)
+{
+    using Callable = typename std::decay<Callback>::type;
+    using Result = Impl::TaskResultType<Callable>;
+
+    Callable callable(std::forward<Callback>(callback));
+    return Impl::RunAsyncAwaiter<Callable, Result>(pool, std::move(callable), priority);
+}
+
+template <typename T>
+T SyncWait(AsyncTask<T>&& task)
+{
+    Impl::SyncWaitLatch latch;
+    std::exception_ptr exception;
+
+    if constexpr (std::is_void<T>::value)
+    {
+        Impl::SyncWaitCoroutine(task, exception, latch);
+        latch.Wait();
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+    else
+    {
+        std::optional<T> result;
+        Impl::SyncWaitCoroutine(task, result, exception, latch);
+        latch.Wait();
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+
+        return std::move(*result);
+    }
+}
+
+} // namespace Utils
+} // namespace lkCommon
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "lkCommon/lkCommon.hpp"
+#include "lkCommon/Utils/ArenaAllocator.hpp"
+
+#include <vector>
+#include <cstddef>
+
+
+namespace lkCommon {
+namespace Utils {
+
+/**
+ * Linear allocator for short-lived scratch memory, ex. temporaries used during a single frame.
+ *
+ * FrameAllocator takes big blocks of memory from an ArenaAllocator and gives them out by moving
+ * a pointer forward, so allocating costs only a couple of instructions. Allocations are never
+ * freed one by one - instead, GetMarker() remembers current position and RewindTo() releases
+ * everything allocated after it at once, in constant time. Scope does the same automatically.
+ *
+ * Blocks stay with FrameAllocator after rewinding and serve following allocations, so a frame
+ * needing no more memory than previous ones does not reach to ArenaAllocator at all. Blocks are
+ * given back to ArenaAllocator by ReleaseBlocks() and when FrameAllocator is destroyed.
+ *
+ * @warning FrameAllocator is not thread-safe, each thread should use its own. Used ArenaAllocator
+ *          can be shared between threads.
+ */
+class FrameAllocator
+{
+public:
+    /**
+     * Position in FrameAllocator, acquired with GetMarker().
+     */
+    struct Marker
+    {
+        size_t block;
+        size_t offset;
+    };
+
+    /**
+     * Rewinds FrameAllocator to position it had when Scope was created, once Scope is destroyed.
+     */
+    class Scope
+    {
+        FrameAllocator& mAllocator;
+        Marker mMarker;
+
+    public:
+        explicit Scope(FrameAllocator& allocator);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /**
+     * Size of blocks taken from ArenaAllocator, unless other was provided to the constructor.
+     */
+    static const size_t DEFAULT_BLOCK_SIZE;
+
+private:
+    struct Block
+    {
+        uint8_t* ptr;
+        size_t size;
+    };
+
+    ArenaAllocator& mAllocator;
+    size_t mBlockSize;
+    std::vector<Block> mBlocks;
+    size_t mCurrentBlock;
+    uint8_t* mCurrent;
+    uint8_t* mEnd;
+
+    void* AllocateFromNextBlock(size_t size, size_t alignment);
+
+public:
+    /**
+     * Create a FrameAllocator. No memory is taken from @p allocator until first allocation.
+     *
+     * @p[in] allocator ArenaAllocator providing blocks of memory. Must outlive FrameAllocator.
+     * @p[in] blockSize Size of blocks taken from @p allocator. Bigger allocations get a block of
+     *                  their own size.
+     */
+    FrameAllocator(ArenaAllocator& allocator, size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    /**
+     * Destroy a FrameAllocator, giving all its blocks back to ArenaAllocator.
+     */
+    ~FrameAllocator();
+
+    FrameAllocator(const FrameAllocator&) = delete;
+    FrameAllocator(FrameAllocator&&) = delete;
+    FrameAllocator& operator=(const FrameAllocator&) = delete;
+    FrameAllocator& operator=(FrameAllocator&&) = delete;
+
+    /**
+     * Allocate data of size @p size aligned to @p alignment and return pointer to it.
+     *
+     * @p[in] size      Size of memory to allocate in bytes.
+     * @p[in] alignment Required alignment of returned pointer in bytes. Must be a power of two.
+     * @return Pointer to allocated memory, or nullptr if ArenaAllocator failed to provide a block.
+     *
+     * Memory stays valid until FrameAllocator is rewound to a position from before this call.
+     */
+    LKCOMMON_INLINE void* Allocate(size_t size, size_t alignment)
+    {
+        const size_t misalignment = static_cast<size_t>(reinterpret_cast<uintptr_t>(mCurrent)) & (alignment - 1);
+        const size_t padding = (alignment - misalignment) & (alignment - 1);
+        if (static_cast<size_t>(mEnd - mCurrent) >= padding + size)
+        {
+            uint8_t* ptr = mCurrent + padding;
+            mCurrent = ptr + size;
+            return ptr;
+        }
+
+        return AllocateFromNextBlock(size, alignment);
+    }
+
+    /**
+     * Allocate data of size @p size, aligned the same way as ArenaAllocator::Allocate(size_t).
+     */
+    LKCOMMON_INLINE void* Allocate(size_t size)
+    {
+        return Allocate(size, ArenaAllocator::GetNaturalAlignment(size, ArenaAllocator::DEFAULT_ALIGNMENT));
+    }
+
+    /**
+     * Returns current position, which can be later passed to RewindTo().
+     */
+    Marker GetMarker() const;
+
+    /**
+     * Release all allocations done after @p marker was acquired.
+     *
+     * @p[in] marker Position acquired by GetMarker(). Markers acquired after it become invalid,
+     *               so markers have to be rewound to in reverse order of acquiring them.
+     */
+    void RewindTo(const Marker& marker);
+
+    /**
+     * Release all allocations. Blocks are kept for further use.
+     */
+    void Reset();
+
+    /**
+     * Release all allocations and give all blocks back to ArenaAllocator.
+     */
+    void ReleaseBlocks();
+
+    /**
+     * Returns amount of blocks taken from ArenaAllocator.
+     */
+    LKCOMMON_INLINE size_t GetBlockCount() const
+    {
+        return mBlocks.size();
+    }
+};
+
+} // namespace Utils
+} // namespace lkCommon
@@ -8,6 +8,7 @@
 #define _LKCOMMON_UTILS_IMAGE_HPP_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <lkCommon/lkCommon.hpp>
@@ -31,12 +32,16 @@ enum class Sampling: unsigned char
  * Image class is made as an utility allowing user to draw any contents on it
  * and display it on Window type object. Data is stored in one-dimensional
  * array using std::vector as a container.
+ *
+ * Pixel memory is acquired through @p Allocator, so it can come ex. from
+ * an ArenaAllocator via ArenaStdAllocator. Allocators which cannot be default
+ * constructed have to be provided to the constructor.
  */
-template <typename PixelType>
+template <typename PixelType, typename Allocator = std::allocator<PixelType>>
 class Image final
 {
 public:
-    using PixelContainer = std::vector<PixelType>;
+    using PixelContainer = std::vector<PixelType, Allocator>;
 
 private:
     uint32_t mWidth;
@@ -61,19 +66,22 @@ public:
     /**
      * Constructs a default empty Image. To fit any data, Resize() must be
      * called after construction.
+     *
+     * @p[in] allocator Allocator used to acquire memory for pixels.
      */
-    Image();
+    explicit Image(const Allocator& allocator = Allocator());
 
     /**
      * Constructs an Image with dimensions @p width x @p height.
      *
-     * @p[in] width  Width of image
-     * @p[in] height Height of image
+     * @p[in] width     Width of image
+     * @p[in] height    Height of image
+     * @p[in] allocator Allocator used to acquire memory for pixels.
      *
      * @note In case of error (ex. not enough memory) constructor may throw.
      * Possible thrown exceptions match std::vector::resize() exceptions.
      */
-    Image(uint32_t width, uint32_t height);
+    Image(uint32_t width, uint32_t height, const Allocator& allocator = Allocator());
 
     /**
      * Constructs an image with dimensions @p width x @p height and fills it
@@ -90,6 +98,8 @@ public:
      * @p[in] data          Data for image to be filled with.
      * @p[in] isBGR         True if provided pixel data is in RGB format.
      *
+     * Pixel memory is acquired with a copy of @p data's allocator.
+     *
      * @note In case of error (ex. not enough memory) constructor may throw.
      * Possible thrown exceptions match std::vector::resize() exceptions.
      */
@@ -102,10 +112,10 @@ public:
      */
     Image(const std::string& path);
 
-    Image(const Image<PixelType>& other);
-    Image(Image<PixelType>&& other);
-    Image& operator=(const Image<PixelType>& other);
-    Image& operator=(Image<PixelType>&& other);
+    Image(const Image<PixelType, Allocator>& other);
+    Image(Image<PixelType, Allocator>&& other);
+    Image& operator=(const Image<PixelType, Allocator>& other);
+    Image& operator=(Image<PixelType, Allocator>&& other);
 
     /**
      * Destroys Image object, freeing all allocated memory.
@@ -46,29 +46,29 @@ _PIXEL_TYPE_INFO_STRUCT_SPEC(lkCommon::Utils::PixelFloat4)
 #undef _PIXEL_TYPE_INFO_STRUCT_SPEC
 
 
-template <typename PixelType>
-Image<PixelType>::Image()
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>::Image(const Allocator& allocator)
     : mWidth(0)
     , mHeight(0)
-    , mPixels()
+    , mPixels(allocator)
     , mWindowImage(mWidth, mHeight, mPixels.data())
 {
 }
 
-template <typename PixelType>
-Image<PixelType>::Image(uint32_t width, uint32_t height)
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>::Image(uint32_t width, uint32_t height, const Allocator& allocator)
     : mWidth(width)
     , mHeight(height)
-    , mPixels(mWidth * mHeight)
+    , mPixels(mWidth * mHeight, allocator)
     , mWindowImage(mWidth, mHeight, mPixels.data())
 {
 }
 
-template <typename PixelType>
-Image<PixelType>::Image(uint32_t width, uint32_t height, uint32_t pixelsPerRow, const Image<PixelType>::PixelContainer& data, bool isBGR)
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>::Image(uint32_t width, uint32_t height, uint32_t pixelsPerRow, const Image<PixelType, Allocator>::PixelContainer& data, bool isBGR)
     : mWidth(width)
     , mHeight(height)
-    , mPixels(mWidth * mHeight)
+    , mPixels(mWidth * mHeight, data.get_allocator())
     , mWindowImage(mWidth, mHeight, mPixels.data())
 {
     if (pixelsPerRow == 0)
@@ -98,8 +98,8 @@ Image<PixelType>::Image(uint32_t width, uint32_t height, uint32_t pixelsPerRow,
     }
 }
 
-template <typename PixelType>
-Image<PixelType>::Image(const std::string& path)
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>::Image(const std::string& path)
     : mWidth(0)
     , mHeight(0)
     , mPixels()
@@ -111,8 +111,8 @@ Image<PixelType>::Image(const std::string& path)
     }
 }
 
-template <typename PixelType>
-Image<PixelType>::Image(const Image<PixelType>& other)
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>::Image(const Image<PixelType, Allocator>& other)
     : mWidth(other.mWidth)
     , mHeight(other.mHeight)
     , mPixels(other.mPixels)
@@ -120,8 +120,8 @@ Image<PixelType>::Image(const Image<PixelType>& other)
 {
 }
 
-template <typename PixelType>
-Image<PixelType>::Image(Image<PixelType>&& other)
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>::Image(Image<PixelType, Allocator>&& other)
     : mWidth(std::move(other.mWidth))
     , mHeight(std::move(other.mHeight))
     , mPixels(std::move(other.mPixels))
@@ -129,8 +129,8 @@ Image<PixelType>::Image(Image<PixelType>&& other)
 {
 }
 
-template <typename PixelType>
-Image<PixelType>& Image<PixelType>::operator=(const Image<PixelType>& other)
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>& Image<PixelType, Allocator>::operator=(const Image<PixelType, Allocator>& other)
 {
     mWidth = other.mWidth;
     mHeight = other.mHeight;
@@ -138,8 +138,8 @@ Image<PixelType>& Image<PixelType>::operator=(const Image<PixelType>& other)
     mWindowImage.Recreate(mWidth, mHeight, mPixels.data());
 }
 
-template <typename PixelType>
-Image<PixelType>& Image<PixelType>::operator=(Image<PixelType>&& other)
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>& Image<PixelType, Allocator>::operator=(Image<PixelType, Allocator>&& other)
 {
     mWidth = std::move(other.mWidth);
     mHeight = std::move(other.mHeight);
@@ -148,13 +148,13 @@ Image<PixelType>& Image<PixelType>::operator=(Image<PixelType>&& other)
 }
 
 
-template <typename PixelType>
-Image<PixelType>::~Image()
+template <typename PixelType, typename Allocator>
+Image<PixelType, Allocator>::~Image()
 {
 }
 
-template <typename PixelType>
-size_t Image<PixelType>::GetPixelCoord(uint32_t x, uint32_t y)
+template <typename PixelType, typename Allocator>
+size_t Image<PixelType, Allocator>::GetPixelCoord(uint32_t x, uint32_t y)
 {
     if (x >= mWidth || y >= mHeight)
     {
@@ -166,8 +166,8 @@ size_t Image<PixelType>::GetPixelCoord(uint32_t x, uint32_t y)
     return y * mWidth + x;
 }
 
-template <typename PixelType>
-size_t Image<PixelType>::GetPixelCoordWrapped(uint32_t x, uint32_t y)
+template <typename PixelType, typename Allocator>
+size_t Image<PixelType, Allocator>::GetPixelCoordWrapped(uint32_t x, uint32_t y)
 {
     if (x >= mWidth)
     {
@@ -181,8 +181,8 @@ size_t Image<PixelType>::GetPixelCoordWrapped(uint32_t x, uint32_t y)
     return y * mWidth + x;
 }
 
-template <typename PixelType>
-PixelType Image<PixelType>::SampleNearest(float x, float y)
+template <typename PixelType, typename Allocator>
+PixelType Image<PixelType, Allocator>::SampleNearest(float x, float y)
 {
     PixelType ret = mPixels[GetPixelCoordWrapped(
         static_cast<uint32_t>(x * mWidth),
@@ -193,8 +193,8 @@ PixelType Image<PixelType>::SampleNearest(float x, float y)
     return ret;
 }
 
-template <typename PixelType>
-PixelType Image<PixelType>::SampleBilinear(float x, float y)
+template <typename PixelType, typename Allocator>
+PixelType Image<PixelType, Allocator>::SampleBilinear(float x, float y)
 {
     const float xCoord = x * mWidth;
     const float yCoord = y * mHeight;
@@ -218,8 +218,8 @@ PixelType Image<PixelType>::SampleBilinear(float x, float y)
     return R;
 }
 
-template <typename PixelType>
-bool Image<PixelType>::Load(const std::string& path)
+template <typename PixelType, typename Allocator>
+bool Image<PixelType, Allocator>::Load(const std::string& path)
 {
     ImageLoaderPtr loader = ImageLoader::SelectLoader(path);
     if (!loader)
@@ -250,8 +250,8 @@ bool Image<PixelType>::Load(const std::string& path)
     return true;
 }
 
-template <typename PixelType>
-bool Image<PixelType>::Resize(uint32_t width, uint32_t height)
+template <typename PixelType, typename Allocator>
+bool Image<PixelType, Allocator>::Resize(uint32_t width, uint32_t height)
 {
     if (mWidth == width && mHeight == height)
         return true;
@@ -275,8 +275,8 @@ bool Image<PixelType>::Resize(uint32_t width, uint32_t height)
     return mWindowImage.Recreate(width, height, mPixels.data());
 }
 
-template <typename PixelType>
-bool Image<PixelType>::SetPixel(uint32_t x, uint32_t y, const PixelType& pixel)
+template <typename PixelType, typename Allocator>
+bool Image<PixelType, Allocator>::SetPixel(uint32_t x, uint32_t y, const PixelType& pixel)
 {
     size_t coord = GetPixelCoord(x, y);
     if (coord == SIZE_MAX)
@@ -289,8 +289,8 @@ bool Image<PixelType>::SetPixel(uint32_t x, uint32_t y, const PixelType& pixel)
     return true;
 }
 
-template <typename PixelType>
-bool Image<PixelType>::GetPixel(uint32_t x, uint32_t y, PixelType& pixel)
+template <typename PixelType, typename Allocator>
+bool Image<PixelType, Allocator>::GetPixel(uint32_t x, uint32_t y, PixelType& pixel)
 {
     size_t coord = GetPixelCoord(x, y);
     if (coord == SIZE_MAX)
@@ -303,15 +303,15 @@ bool Image<PixelType>::GetPixel(uint32_t x, uint32_t y, PixelType& pixel)
     return true;
 }
 
-template <typename PixelType>
-void Image<PixelType>::SetAllPixels(const PixelType& color)
+template <typename PixelType, typename Allocator>
+void Image<PixelType, Allocator>::SetAllPixels(const PixelType& color)
 {
     for (uint32_t i = 0; i < mPixels.size(); ++i)
         mPixels[i] = color;
 }
 
-template <typename PixelType>
-PixelType Image<PixelType>::Sample(float x, float y, Sampling samplingType)
+template <typename PixelType, typename Allocator>
+PixelType Image<PixelType, Allocator>::Sample(float x, float y, Sampling samplingType)
 {
     // skip sampling if we have 1x1 dimensions
     if (mWidth == 1 && mHeight == 1)
@@ -329,9 +329,9 @@ PixelType Image<PixelType>::Sample(float x, float y, Sampling samplingType)
     }
 }
 
-template <typename PixelType>
+template <typename PixelType, typename Allocator>
 template <typename ConvType>
-Image<PixelType>::operator Image<ConvType>() const
+Image<PixelType, Allocator>::operator Image<ConvType>() const
 {
     typename Image<ConvType>::PixelContainer resultData(mPixels.size());
 
@@ -0,0 +1,155 @@
+#pragma once
+#define _LKCOMMON_UTILS_OBJECT_POOL_HPP_
+
+#include "lkCommon/lkCommon.hpp"
+#include "lkCommon/Utils/ArenaAllocator.hpp"
+
+#include <vector>
+#include <cstddef>
+
+
+namespace lkCommon {
+namespace Utils {
+
+/**
+ * Pool of objects of a single type, with memory taken from ArenaAllocator.
+ *
+ * ObjectPool takes chunks holding multiple equally sized slots from ArenaAllocator. Released
+ * slots are linked into an intrusive free list, stored in the slots themselves, so both Acquire()
+ * and Release() take constant time and never lock - the allocator is reached for only when all
+ * slots are in use.
+ *
+ * Slots are aligned to @p SlotAlignment, which by default is alignment of @p T. Passing
+ * CACHE_LINE_SIZE places each object on cache lines of its own, which prevents false sharing
+ * between objects used by different threads, at the cost of more memory.
+ *
+ * Chunks are given back to ArenaAllocator when ObjectPool is destroyed. Objects which were not
+ * released by then are not destroyed.
+ *
+ * @warning ObjectPool is not thread-safe, each thread should use its own. Used ArenaAllocator
+ *          can be shared between threads.
+ */
+template <typename T, size_t SlotAlignment = alignof(T)>
+class ObjectPool
+{
+    static_assert(SlotAlignment > 0 && (SlotAlignment & (SlotAlignment - 1)) == 0,
+                  "ObjectPool slot alignment must be a power of two");
+    static_assert(SlotAlignment >= alignof(T), "ObjectPool slot alignment must fit object's alignment");
+
+    // slot has to fit a free list link when it does not hold an object
+    static const size_t SLOT_SIZE =
+        (((sizeof(T) > sizeof(void*)) ? sizeof(T) : sizeof(void*)) + SlotAlignment - 1) & ~(SlotAlignment - 1);
+
+    ArenaAllocator& mAllocator;
+    size_t mSlotsPerChunk;
+    std::vector<uint8_t*> mChunks;
+    uint8_t* mFreeList;
+    uint8_t* mCurrent; // next never used slot in most recent chunk
+    uint8_t* mEnd;
+    size_t mUsedCount;
+
+    uint8_t* GetSlot();
+    void PutSlot(uint8_t* slot);
+    uint8_t* GetSlotFromNewChunk();
+
+public:
+    /**
+     * Alignment placing slots on separate cache lines.
+     */
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * Amount of slots in a chunk, unless other was provided to the constructor.
+     */
+    static const size_t DEFAULT_SLOTS_PER_CHUNK = 256;
+
+    /**
+     * Create an ObjectPool. No memory is taken from @p allocator until first object is acquired.
+     *
+     * @p[in] allocator     ArenaAllocator providing chunks of memory. Must outlive ObjectPool.
+     * @p[in] slotsPerChunk Amount of objects fitting in a single chunk.
+     */
+    ObjectPool(ArenaAllocator& allocator, size_t slotsPerChunk = DEFAULT_SLOTS_PER_CHUNK);
+
+    /**
+     * Destroy an ObjectPool, giving all its chunks back to ArenaAllocator.
+     */
+    ~ObjectPool();
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool(ObjectPool&&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+    ObjectPool& operator=(ObjectPool&&) = delete;
+
+    /**
+     * Construct an object in a free slot.
+     *
+     * @p[in] args Arguments forwarded to object's constructor.
+     * @return Pointer to constructed object, or nullptr if a new chunk was needed and
+     *         ArenaAllocator failed to provide it.
+     */
+    template <typename... Args>
+    T* Acquire(Args&&... args);
+
+    /**
+     * Destroy an object and make its slot free to use again.
+     *
+     * @p[in] object Object acquired from this pool.
+     */
+    void Release(T* object);
+
+    /**
+     * Construct multiple objects at once.
+     *
+     * @p[out] objects Array receiving pointers to constructed objects.
+     * @p[in]  count   Amount of objects to construct.
+     * @p[in]  args    Arguments passed to constructor of each object.
+     * @return Amount of constructed objects, lower than @p count only if ArenaAllocator failed to
+     *         provide a chunk.
+     *
+     * Slots for all objects are gathered before any object is constructed, taking new chunks one
+     * by one as previous ones fill up, so construction is not interrupted by reaching to the
+     * allocator. If a chunk cannot be taken, slots gathered so far are used and the rest of
+     * @p objects is left untouched.
+     */
+    template <typename... Args>
+    size_t AcquireBulk(T** objects, size_t count, const Args&... args);
+
+    /**
+     * Destroy multiple objects at once and make their slots free to use again.
+     *
+     * @p[in] objects Array of objects acquired from this pool.
+     * @p[in] count   Amount of objects in @p objects array.
+     */
+    void ReleaseBulk(T* const* objects, size_t count);
+
+    /**
+     * Returns amount of objects acquired and not yet released.
+     */
+    LKCOMMON_INLINE size_t GetUsedCount() const
+    {
+        return mUsedCount;
+    }
+
+    /**
+     * Returns amount of objects pool can hold without taking more chunks from ArenaAllocator.
+     */
+    LKCOMMON_INLINE size_t GetCapacity() const
+    {
+        return mChunks.size() * mSlotsPerChunk;
+    }
+
+    /**
+     * Returns size of a single slot in bytes.
+     */
+    static constexpr size_t GetSlotSize()
+    {
+        return SLOT_SIZE;
+    }
+};
+
+} // namespace Utils
+} // namespace lkCommon
+
+
+#include "ObjectPoolImpl.hpp"
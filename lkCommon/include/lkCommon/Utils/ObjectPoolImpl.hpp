@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef _LKCOMMON_UTILS_OBJECT_POOL_HPP_
+#error "Please include main header of ObjectPool, not the implementation header."
+#endif // _LKCOMMON_UTILS_OBJECT_POOL_HPP_
+
+#include "ObjectPool.hpp"
+#include "lkCommon/Utils/Logger.hpp"
+
+#include <cstring>
+#include <new>
+#include <utility>
+
+
+namespace lkCommon {
+namespace Utils {
+
+template <typename T, size_t SlotAlignment>
+const size_t ObjectPool<T, SlotAlignment>::SLOT_SIZE;
+
+template <typename T, size_t SlotAlignment>
+const size_t ObjectPool<T, SlotAlignment>::CACHE_LINE_SIZE;
+
+template <typename T, size_t SlotAlignment>
+const size_t ObjectPool<T, SlotAlignment>::DEFAULT_SLOTS_PER_CHUNK;
+
+template <typename T, size_t SlotAlignment>
+ObjectPool<T, SlotAlignment>::ObjectPool(ArenaAllocator& allocator, size_t slotsPerChunk)
+    : mAllocator(allocator)
+    , mSlotsPerChunk(slotsPerChunk)
+    , mChunks()
+    , mFreeList(nullptr)
+    , mCurrent(nullptr)
+    , mEnd(nullptr)
+    , mUsedCount(0)
+{
+    LKCOMMON_ASSERT(mSlotsPerChunk > 0, "ObjectPool chunk must hold at least one slot");
+}
+
+template <typename T, size_t SlotAlignment>
+ObjectPool<T, SlotAlignment>::~ObjectPool()
+{
+    for (uint8_t* chunk: mChunks)
+    {
+        // first slot might hold anything, including ArenaAllocator's magic marking freed memory
+        *reinterpret_cast<uint32_t*>(chunk) = 0;
+        mAllocator.Free(chunk);
+    }
+}
+
+template <typename T, size_t SlotAlignment>
+uint8_t* ObjectPool<T, SlotAlignment>::GetSlotFromNewChunk()
+{
+    uint8_t* chunk = reinterpret_cast<uint8_t*>(mAllocator.Allocate(SLOT_SIZE * mSlotsPerChunk, SlotAlignment));
+    if (chunk == nullptr)
+    {
+        LOGE("Failed to acquire chunk of " << mSlotsPerChunk << " slots for object pool");
+        return nullptr;
+    }
+
+    mChunks.push_back(chunk);
+    mCurrent = chunk + SLOT_SIZE;
+    mEnd = chunk + SLOT_SIZE * mSlotsPerChunk;
+    return chunk;
+}
+
+template <typename T, size_t SlotAlignment>
+LKCOMMON_INLINE uint8_t* ObjectPool<T, SlotAlignment>::GetSlot()
+{
+    uint8_t* slot = mFreeList;
+    if (slot != nullptr)
+    {
+        memcpy(&mFreeList, slot, sizeof(uint8_t*));
+        return slot;
+    }
+
+    if (mCurrent != mEnd)
+    {
+        slot = mCurrent;
+        mCurrent += SLOT_SIZE;
+        return slot;
+    }
+
+    return GetSlotFromNewChunk();
+}
+
+template <typename T, size_t SlotAlignment>
+LKCOMMON_INLINE void ObjectPool<T, SlotAlignment>::PutSlot(uint8_t* slot)
+{
+    // slots are aligned only for the object, which might not be enough for a pointer
+    memcpy(slot, &mFreeList, sizeof(uint8_t*));
+    mFreeList = slot;
+}
+
+template <typename T, size_t SlotAlignment>
+template <typename... Args>
+T* ObjectPool<T, SlotAlignment>::Acquire(Args&&... args)
+{
+    uint8_t* slot = GetSlot();
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+
+    mUsedCount++;
+    return new (slot) T(std::forward<Args>(args)...);
+}
+
+template <typename T, size_t SlotAlignment>
+void ObjectPool<T, SlotAlignment>::Release(T* object)
+{
+    LKCOMMON_ASSERT(mUsedCount > 0, "Released more objects than were acquired from ObjectPool");
+
+    object->~T();
+    PutSlot(reinterpret_cast<uint8_t*>(object));
+    mUsedCount--;
+}
+
+template <typename T, size_t SlotAlignment>
+template <typename... Args>
+size_t ObjectPool<T, SlotAlignment>::AcquireBulk(T** objects, size_t count, const Args&... args)
+{
+    // gather slots first, so constructors run back to back
+    size_t acquired = 0;
+    for (; acquired < count; ++acquired)
+    {
+        uint8_t* slot = GetSlot();
+        if (slot == nullptr)
+        {
+            break;
+        }
+
+        objects[acquired] = reinterpret_cast<T*>(slot);
+    }
+
+    for (size_t i = 0; i < acquired; ++i)
+    {
+        new (objects[i]) T(args...);
+    }
+
+    mUsedCount += acquired;
+    return acquired;
+}
+
+template <typename T, size_t SlotAlignment>
+void ObjectPool<T, SlotAlignment>::ReleaseBulk(T* const* objects, size_t count)
+{
+    LKCOMMON_ASSERT(mUsedCount >= count, "Released more objects than were acquired from ObjectPool");
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        objects[i]->~T();
+    }
+
+    // slots are linked in reverse, so the next bulk acquire gets them back in the original order
+    for (size_t i = count; i > 0; --i)
+    {
+        PutSlot(reinterpret_cast<uint8_t*>(objects[i - 1]));
+    }
+
+    mUsedCount -= count;
+}
+
+} // namespace Utils
+} // namespace lkCommon
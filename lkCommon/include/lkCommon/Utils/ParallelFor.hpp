@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @author LKostyra (costyrra.xl@gmail.com)
+ * @brief  Parallel loop primitives built on top of ThreadPool
+ */
+
+#pragma once
+#define _LKCOMMON_UTILS_PARALLEL_FOR_HPP_
+
+#include <lkCommon/Utils/ThreadPool.hpp>
+
+
+namespace lkCommon {
+namespace Utils {
+
+/**
+ * Calls @p callback for each index in range [@p begin, @p end) using worker
+ * threads of @p pool.
+ *
+ * @p[in] pool     Thread Pool to execute the loop on.
+ * @p[in] begin    First index of the range.
+ * @p[in] end      Index one past the last index of the range.
+ * @p[in] grain    Amount of indices processed by a worker in one go. If equal
+ *                 to zero, grain size will be picked automatically.
+ * @p[in] callback Callback to call for each index. Must be callable as
+ *                 callback(ThreadPayload& payload, size_t index).
+ *
+ * Range is split into chunks of @p grain indices. Pool's workers pick chunks
+ * one by one until there are none left, so fast workers will take over the
+ * work of slow ones. Function returns when all indices were processed. It
+ * does not wait for any other tasks present in @p pool.
+ *
+ * @note Callback receives ThreadPayload of a worker executing the chunk, so
+ *       data set with ThreadPool::SetUserPayloadForThread() is available.
+ *
+ * @note When called from inside of @p pool's task, calling worker thread
+ *       processes chunks as well instead of idly waiting. Thus, ParallelFor
+ *       calls can be nested.
+ */
+template <typename Callback>
+void ParallelFor(ThreadPool& pool, size_t begin, size_t end, size_t grain, Callback&& callback);
+
+/**
+ * Calls @p callback for each point of @p width x @p height area, in tiles,
+ * using worker threads of @p pool.
+ *
+ * @p[in] pool       Thread Pool to execute the loop on.
+ * @p[in] width      Width of the area, ex. Image::GetWidth().
+ * @p[in] height     Height of the area, ex. Image::GetHeight().
+ * @p[in] tileWidth  Width of a single tile. Must be greater than zero.
+ * @p[in] tileHeight Height of a single tile. Must be greater than zero.
+ * @p[in] callback   Callback to call for each point. Must be callable as
+ *                   callback(ThreadPayload& payload, uint32_t x, uint32_t y).
+ *
+ * Tiles are distributed between workers the same way as chunks in
+ * ParallelFor(). Points inside of a tile are visited row by row. Tiles on
+ * the right and bottom edges are clipped to the area.
+ *
+ * @sa ParallelFor
+ */
+template <typename Callback>
+void ParallelFor2D(ThreadPool& pool, uint32_t width, uint32_t height,
+                   uint32_t tileWidth, uint32_t tileHeight, Callback&& callback);
+
+} // namespace Utils
+} // namespace lkCommon
+
+#include "ParallelForImpl.hpp"
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @author LKostyra (costyrra.xl@gmail.com)
+ * @brief  Parallel loop primitives implementation
+ */
+
+#pragma once
+
+#ifndef _LKCOMMON_UTILS_PARALLEL_FOR_HPP_
+#error "Please include main header of ParallelFor, not the implementation header."
+#endif // _LKCOMMON_UTILS_PARALLEL_FOR_HPP_
+
+#include <algorithm>
+#include <memory>
+
+
+namespace lkCommon {
+namespace Utils {
+namespace Impl {
+
+/**
+ * State shared between all tasks working on a single parallel loop.
+ *
+ * Tasks keep the state alive, because some of them might start only after
+ * the loop was finished by others - such tasks find no chunks left and leave
+ * without touching the callback.
+ */
+template <typename ChunkCallback>
+struct ParallelForState
+{
+    ChunkCallback* callback;
+    size_t chunkCount;
+    std::atomic<size_t> nextChunk;
+    std::atomic<size_t> doneChunks;
+    std::mutex doneMutex;
+    std::condition_variable doneCV;
+
+    ParallelForState(ChunkCallback* cb, size_t chunks)
+        : callback(cb)
+        , chunkCount(chunks)
+        , nextChunk(0)
+        , doneChunks(0)
+        , doneMutex()
+        , doneCV()
+    {
+    }
+};
+
+template <typename ChunkCallback>
+void ParallelForProcessChunks(ParallelForState<ChunkCallback>& state, ThreadPayload& payload)
+{
+    size_t processed = 0;
+    size_t chunk;
+    while ((chunk = state.nextChunk.fetch_add(1)) < state.chunkCount)
+    {
+        (*state.callback)(payload, chunk);
+        processed++;
+    }
+
+    if (processed > 0 &&
+        state.doneChunks.fetch_add(processed) + processed == state.chunkCount)
+    {
+        std::lock_guard<std::mutex> lock(state.doneMutex);
+        state.doneCV.notify_all();
+    }
+}
+
+template <typename ChunkCallback>
+void ParallelForChunks(ThreadPool& pool, size_t chunkCount, ChunkCallback& chunkCallback)
+{
+    if (chunkCount == 0)
+    {
+        return;
+    }
+
+    using State = ParallelForState<ChunkCallback>;
+    std::shared_ptr<State> state = std::make_shared<State>(&chunkCallback, chunkCount);
+
+    const size_t taskCount = std::min(pool.GetWorkerThreadCount(), chunkCount);
+    pool.AddTasks(taskCount, [state](ThreadPayload& payload, size_t) {
+        ParallelForProcessChunks(*state, payload);
+    });
+
+    // worker threads calling us help out, so nested loops cannot starve the pool
+    ThreadPayload* workerPayload = pool.GetCurrentWorkerPayload();
+    if (workerPayload != nullptr)
+    {
+        ParallelForProcessChunks(*state, *workerPayload);
+    }
+
+    std::unique_lock<std::mutex> lock(state->doneMutex);
+    state->doneCV.wait(lock, [&state]() {
+        return state->doneChunks.load() == state->chunkCount;
+    });
+}
+
+} // namespace Impl
+
+
+template <typename Callback>
+void ParallelFor(ThreadPool& pool, size_t begin, size_t end, size_t grain, Callback&& callback)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    const size_t count = end - begin;
+    if (grain == 0)
+    {
+        // aim at few chunks per worker to leave some room for load balancing
+        grain = std::max<size_t>(1, count / (pool.GetWorkerThreadCount() * 4));
+    }
+
+    const size_t chunkCount = (count + grain - 1) / grain;
+    auto chunkCallback = [begin, end, grain, &callback](ThreadPayload& payload, size_t chunk) {
+        const size_t chunkBegin = begin + chunk * grain;
+        const size_t chunkEnd = std::min(chunkBegin + grain, end);
+        for (size_t i = chunkBegin; i < chunkEnd; ++i)
+        {
+            callback(payload, i);
+        }
+    };
+
+    Impl::ParallelForChunks(pool, chunkCount, chunkCallback);
+}
+
+template <typename Callback>
+void ParallelFor2D(ThreadPool& pool, uint32_t width, uint32_t height,
+                   uint32_t tileWidth, uint32_t tileHeight, Callback&& callback)
+{
+    LKCOMMON_ASSERT(tileWidth > 0 && tileHeight > 0, "Tile dimensions must be greater than zero");
+
+    const size_t tilesX = (width + tileWidth - 1) / tileWidth;
+    const size_t tilesY = (height + tileHeight - 1) / tileHeight;
+
+    auto chunkCallback = [=, &callback](ThreadPayload& payload, size_t tile) {
+        const uint32_t tileX = static_cast<uint32_t>(tile % tilesX) * tileWidth;
+        const uint32_t tileY = static_cast<uint32_t>(tile / tilesX) * tileHeight;
+        const uint32_t tileEndX = std::min(tileX + tileWidth, width);
+        const uint32_t tileEndY = std::min(tileY + tileHeight, height);
+
+        for (uint32_t y = tileY; y < tileEndY; ++y)
+        {
+            for (uint32_t x = tileX; x < tileEndX; ++x)
+            {
+                callback(payload, x, y);
+            }
+        }
+    };
+
+    Impl::ParallelForChunks(pool, tilesX * tilesY, chunkCallback);
+}
+
+} // namespace Utils
+} // namespace lkCommon
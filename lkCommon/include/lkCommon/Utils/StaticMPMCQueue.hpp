@@ -0,0 +1,128 @@
+#pragma once
+#define _LKCOMMON_UTILS_STATIC_MPMC_QUEUE_HPP_
+
+#include "lkCommon/lkCommon.hpp"
+
+#include <atomic>
+#include <type_traits>
+#include <cstddef>
+
+
+namespace lkCommon {
+namespace Utils {
+
+/**
+ * A lock-free FIFO queue with fixed capacity and zero dynamic allocations,
+ * which can be used by multiple producer and multiple consumer threads at the
+ * same time.
+ *
+ * Each slot of the queue holds a sequence number telling whether the slot is
+ * ready to be written or read in current lap around the ring. Producers and
+ * consumers claim slots by advancing their own position with a single CAS, so
+ * threads never block each other and a push or a pop touches only the slot it
+ * claimed and one position counter. Producer and consumer positions are kept
+ * on separate cache lines.
+ *
+ * Unlike StaticQueue, pushing to a full queue and popping from an empty one is
+ * not an error - Try* functions return false in such case and caller decides
+ * what to do (ex. retry, or fall back to another container).
+ *
+ * @p T must be nothrow move constructible. @p N must be a power of two.
+ */
+template <typename T, size_t N>
+class StaticMPMCQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "StaticMPMCQueue capacity must be a power of two");
+    static_assert(std::is_nothrow_move_constructible<T>::value, "StaticMPMCQueue requires nothrow movable type");
+
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type object;
+    };
+
+    // positions are padded instead of using alignas, so the queue can be
+    // embedded in heap-allocated objects without over-aligned new (C++17)
+    Cell mCells[N];
+    char mPadding0[CACHE_LINE_SIZE];
+    std::atomic<size_t> mEnqueuePos;
+    char mPadding1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> mDequeuePos;
+    char mPadding2[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+    // Claims a cell for writing, returns nullptr if queue is full
+    Cell* ClaimPushCell(size_t& pos);
+
+public:
+    StaticMPMCQueue();
+    ~StaticMPMCQueue();
+
+    StaticMPMCQueue(const StaticMPMCQueue&) = delete;
+    StaticMPMCQueue& operator=(const StaticMPMCQueue&) = delete;
+
+    /**
+     * Copy an object to a queue.
+     *
+     * @p[in] object Object to be copied on a queue.
+     * @return True if object was pushed, false if queue was full.
+     */
+    bool TryPush(const T& object);
+
+    /**
+     * Move an object to a queue.
+     *
+     * @p[in] object Object to be moved on a queue. Object is left untouched if
+     *               queue was full.
+     * @return True if object was pushed, false if queue was full.
+     */
+    bool TryPush(T&& object);
+
+    /**
+     * Construct an object and put it on a queue.
+     *
+     * @p[in] args Arguments forwarded to object's constructor.
+     * @return True if object was constructed, false if queue was full.
+     */
+    template <typename... Args>
+    bool TryEmplace(Args&&... args);
+
+    /**
+     * Get the oldest element from a queue.
+     *
+     * @p[out] object Object to which popped element is moved.
+     * @return True if element was popped, false if queue was empty.
+     */
+    bool TryPop(T& object);
+
+    /**
+     * Acquire queue's max possible size.
+     */
+    constexpr size_t Capacity() const
+    {
+        return N;
+    }
+
+    /**
+     * Acquire amount of elements on queue.
+     *
+     * @note With other threads using the queue, returned value is only an
+     *       approximation and might be outdated right away.
+     */
+    size_t Size() const;
+
+    /**
+     * Returns true if queue looks empty at the moment of the call.
+     */
+    LKCOMMON_INLINE bool IsEmpty() const
+    {
+        return Size() == 0;
+    }
+};
+
+} // namespace Utils
+} // namespace lkCommon
+
+
+#include "StaticMPMCQueueImpl.hpp"
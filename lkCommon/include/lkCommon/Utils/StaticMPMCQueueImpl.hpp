@@ -0,0 +1,157 @@
+#pragma once
+
+#ifndef _LKCOMMON_UTILS_STATIC_MPMC_QUEUE_HPP_
+#error "Please include main header of StaticMPMCQueue, not the implementation header."
+#endif // _LKCOMMON_UTILS_STATIC_MPMC_QUEUE_HPP_
+
+#include "StaticMPMCQueue.hpp"
+
+#include <new>
+#include <utility>
+
+
+namespace lkCommon {
+namespace Utils {
+
+template <typename T, size_t N>
+const size_t StaticMPMCQueue<T, N>::CACHE_LINE_SIZE;
+
+template <typename T, size_t N>
+StaticMPMCQueue<T, N>::StaticMPMCQueue()
+    : mEnqueuePos(0)
+    , mDequeuePos(0)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        mCells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T, size_t N>
+StaticMPMCQueue<T, N>::~StaticMPMCQueue()
+{
+    // destroy elements which were never popped
+    const size_t end = mEnqueuePos.load(std::memory_order_relaxed);
+    for (size_t pos = mDequeuePos.load(std::memory_order_relaxed); pos != end; ++pos)
+    {
+        reinterpret_cast<T*>(&mCells[pos & (N - 1)].object)->~T();
+    }
+}
+
+template <typename T, size_t N>
+typename StaticMPMCQueue<T, N>::Cell* StaticMPMCQueue<T, N>::ClaimPushCell(size_t& pos)
+{
+    pos = mEnqueuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Cell* cell = &mCells[pos & (N - 1)];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            // cell is free in this lap - try to claim it
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                return cell;
+            }
+        }
+        else if (diff < 0)
+        {
+            // cell still holds an element from previous lap - queue is full
+            return nullptr;
+        }
+        else
+        {
+            // other producer claimed the cell before us
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T, size_t N>
+bool StaticMPMCQueue<T, N>::TryPush(const T& object)
+{
+    return TryEmplace(object);
+}
+
+template <typename T, size_t N>
+bool StaticMPMCQueue<T, N>::TryPush(T&& object)
+{
+    return TryEmplace(std::move(object));
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+bool StaticMPMCQueue<T, N>::TryEmplace(Args&&... args)
+{
+    size_t pos;
+    Cell* cell = ClaimPushCell(pos);
+    if (cell == nullptr)
+    {
+        return false;
+    }
+
+    new (&cell->object) T(std::forward<Args>(args)...);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t N>
+bool StaticMPMCQueue<T, N>::TryPop(T& object)
+{
+    size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true)
+    {
+        cell = &mCells[pos & (N - 1)];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+        if (diff == 0)
+        {
+            // cell holds an element of this lap - try to claim it
+            if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // cell was not written yet - queue is empty
+            return false;
+        }
+        else
+        {
+            // other consumer claimed the cell before us
+            pos = mDequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    T* stored = reinterpret_cast<T*>(&cell->object);
+    object = std::move(*stored);
+    stored->~T();
+
+    // cell becomes free for producers in the next lap
+    cell->sequence.store(pos + N, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t N>
+size_t StaticMPMCQueue<T, N>::Size() const
+{
+    const size_t dequeuePos = mDequeuePos.load(std::memory_order_relaxed);
+    const size_t enqueuePos = mEnqueuePos.load(std::memory_order_relaxed);
+
+    // positions are read separately, so they can be briefly inconsistent
+    if (enqueuePos <= dequeuePos)
+    {
+        return 0;
+    }
+
+    const size_t size = enqueuePos - dequeuePos;
+    return (size > N) ? N : size;
+}
+
+} // namespace Utils
+} // namespace lkCommon
@@ -0,0 +1,155 @@
+#pragma once
+#define _LKCOMMON_UTILS_STATIC_SPSC_QUEUE_HPP_
+
+#include "lkCommon/lkCommon.hpp"
+
+#include <atomic>
+#include <type_traits>
+#include <cstddef>
+
+
+namespace lkCommon {
+namespace Utils {
+
+/**
+ * A wait-free FIFO queue with fixed capacity and zero dynamic allocations,
+ * meant for passing objects from exactly one producer thread to exactly one
+ * consumer thread.
+ *
+ * Producer only writes the tail index and consumer only writes the head index,
+ * so neither side ever waits for the other or retries an operation. Both
+ * indices live on separate cache lines, next to a private copy of the other
+ * side's index - the other side's cache line is read only when the copy
+ * suggests the queue is full (for producer) or empty (for consumer).
+ *
+ * Batch functions move multiple objects with a single index update, which
+ * reduces cache line traffic between threads even further.
+ *
+ * @p N must be a power of two.
+ *
+ * @warning Push functions can be called only from one thread and Pop functions
+ *          only from one (possibly other) thread at a time. Size() and
+ *          IsEmpty() can be called from any thread.
+ */
+template <typename T, size_t N>
+class StaticSPSCQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "StaticSPSCQueue capacity must be a power of two");
+
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    // producer's data
+    std::atomic<size_t> mTail;
+    size_t mCachedHead;
+    char mPadding0[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    // consumer's data
+    std::atomic<size_t> mHead;
+    size_t mCachedTail;
+    char mPadding1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    Storage mObjects[N];
+
+    LKCOMMON_INLINE T* GetObject(size_t index)
+    {
+        return reinterpret_cast<T*>(&mObjects[index & (N - 1)]);
+    }
+
+    // Returns amount of free slots producer can fill, up to @p count
+    size_t ReservePush(size_t count);
+    // Returns amount of filled slots consumer can take, up to @p count
+    size_t ReservePop(size_t count);
+
+public:
+    StaticSPSCQueue();
+    ~StaticSPSCQueue();
+
+    StaticSPSCQueue(const StaticSPSCQueue&) = delete;
+    StaticSPSCQueue& operator=(const StaticSPSCQueue&) = delete;
+
+    /**
+     * Copy an object to a queue.
+     *
+     * @p[in] object Object to be copied on a queue.
+     * @return True if object was pushed, false if queue was full.
+     */
+    bool TryPush(const T& object);
+
+    /**
+     * Move an object to a queue.
+     *
+     * @p[in] object Object to be moved on a queue. Object is left untouched if
+     *               queue was full.
+     * @return True if object was pushed, false if queue was full.
+     */
+    bool TryPush(T&& object);
+
+    /**
+     * Construct an object and put it on a queue.
+     *
+     * @p[in] args Arguments forwarded to object's constructor.
+     * @return True if object was constructed, false if queue was full.
+     */
+    template <typename... Args>
+    bool TryEmplace(Args&&... args);
+
+    /**
+     * Copy multiple objects to a queue at once.
+     *
+     * @p[in] objects Array of objects to be copied on a queue.
+     * @p[in] count   Amount of objects in @p objects array.
+     * @return Amount of objects pushed, which is lower than @p count if queue
+     *         got full. Objects are always pushed starting from first one.
+     */
+    size_t TryPushBatch(const T* objects, size_t count);
+
+    /**
+     * Get the oldest element from a queue.
+     *
+     * @p[out] object Object to which popped element is moved.
+     * @return True if element was popped, false if queue was empty.
+     */
+    bool TryPop(T& object);
+
+    /**
+     * Get multiple oldest elements from a queue at once.
+     *
+     * @p[out] objects  Array to which popped elements are moved, in order
+     *                  they were pushed.
+     * @p[in]  maxCount Size of @p objects array.
+     * @return Amount of elements popped, zero if queue was empty.
+     */
+    size_t TryPopBatch(T* objects, size_t maxCount);
+
+    /**
+     * Acquire queue's max possible size.
+     */
+    constexpr size_t Capacity() const
+    {
+        return N;
+    }
+
+    /**
+     * Acquire amount of elements on queue.
+     *
+     * @note While the other side keeps using the queue, returned value is
+     *       only an approximation and might be outdated right away.
+     */
+    size_t Size() const;
+
+    /**
+     * Returns true if queue looks empty at the moment of the call.
+     */
+    LKCOMMON_INLINE bool IsEmpty() const
+    {
+        return Size() == 0;
+    }
+};
+
+} // namespace Utils
+} // namespace lkCommon
+
+
+#include "StaticSPSCQueueImpl.hpp"
@@ -0,0 +1,161 @@
+#pragma once
+
+#ifndef _LKCOMMON_UTILS_STATIC_SPSC_QUEUE_HPP_
+#error "Please include main header of StaticSPSCQueue, not the implementation header."
+#endif // _LKCOMMON_UTILS_STATIC_SPSC_QUEUE_HPP_
+
+#include "StaticSPSCQueue.hpp"
+
+#include <new>
+#include <utility>
+
+
+namespace lkCommon {
+namespace Utils {
+
+template <typename T, size_t N>
+const size_t StaticSPSCQueue<T, N>::CACHE_LINE_SIZE;
+
+template <typename T, size_t N>
+StaticSPSCQueue<T, N>::StaticSPSCQueue()
+    : mTail(0)
+    , mCachedHead(0)
+    , mHead(0)
+    , mCachedTail(0)
+{
+}
+
+template <typename T, size_t N>
+StaticSPSCQueue<T, N>::~StaticSPSCQueue()
+{
+    // destroy elements which were never popped
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    for (size_t i = mHead.load(std::memory_order_relaxed); i != tail; ++i)
+    {
+        GetObject(i)->~T();
+    }
+}
+
+template <typename T, size_t N>
+size_t StaticSPSCQueue<T, N>::ReservePush(size_t count)
+{
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    size_t free = N - (tail - mCachedHead);
+    if (free < count)
+    {
+        // consumer might have made some room since we last checked
+        mCachedHead = mHead.load(std::memory_order_acquire);
+        free = N - (tail - mCachedHead);
+    }
+
+    return (free < count) ? free : count;
+}
+
+template <typename T, size_t N>
+size_t StaticSPSCQueue<T, N>::ReservePop(size_t count)
+{
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    size_t available = mCachedTail - head;
+    if (available < count)
+    {
+        // producer might have pushed more since we last checked
+        mCachedTail = mTail.load(std::memory_order_acquire);
+        available = mCachedTail - head;
+    }
+
+    return (available < count) ? available : count;
+}
+
+template <typename T, size_t N>
+bool StaticSPSCQueue<T, N>::TryPush(const T& object)
+{
+    return TryEmplace(object);
+}
+
+template <typename T, size_t N>
+bool StaticSPSCQueue<T, N>::TryPush(T&& object)
+{
+    return TryEmplace(std::move(object));
+}
+
+template <typename T, size_t N>
+template <typename... Args>
+bool StaticSPSCQueue<T, N>::TryEmplace(Args&&... args)
+{
+    if (ReservePush(1) == 0)
+    {
+        return false;
+    }
+
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    new (GetObject(tail)) T(std::forward<Args>(args)...);
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t N>
+size_t StaticSPSCQueue<T, N>::TryPushBatch(const T* objects, size_t count)
+{
+    const size_t pushCount = ReservePush(count);
+    if (pushCount == 0)
+    {
+        return 0;
+    }
+
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < pushCount; ++i)
+    {
+        new (GetObject(tail + i)) T(objects[i]);
+    }
+
+    // whole batch is published to consumer at once
+    mTail.store(tail + pushCount, std::memory_order_release);
+    return pushCount;
+}
+
+template <typename T, size_t N>
+bool StaticSPSCQueue<T, N>::TryPop(T& object)
+{
+    return TryPopBatch(&object, 1) == 1;
+}
+
+template <typename T, size_t N>
+size_t StaticSPSCQueue<T, N>::TryPopBatch(T* objects, size_t maxCount)
+{
+    const size_t popCount = ReservePop(maxCount);
+    if (popCount == 0)
+    {
+        return 0;
+    }
+
+    const size_t head = mHead.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < popCount; ++i)
+    {
+        T* stored = GetObject(head + i);
+        objects[i] = std::move(*stored);
+        stored->~T();
+    }
+
+    // slots are handed back to producer at once
+    mHead.store(head + popCount, std::memory_order_release);
+    return popCount;
+}
+
+template <typename T, size_t N>
+size_t StaticSPSCQueue<T, N>::Size() const
+{
+    const size_t head = mHead.load(std::memory_order_acquire);
+    const size_t tail = mTail.load(std::memory_order_acquire);
+
+    // indices are read separately, so they can be briefly inconsistent
+    if (tail <= head)
+    {
+        return 0;
+    }
+
+    const size_t size = tail - head;
+    return (size > N) ? N : size;
+}
+
+} // namespace Utils
+} // namespace lkCommon
@@ -0,0 +1,124 @@
+/**
+ * @file
+ * @author LKostyra (costyrra.xl@gmail.com)
+ * @brief  Task dependency graph executed on ThreadPool
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <atomic>
+
+#include <lkCommon/lkCommon.hpp>
+#include <lkCommon/Utils/ThreadPool.hpp>
+
+
+namespace lkCommon {
+namespace Utils {
+
+/**
+ * Graph of tasks with dependencies between them, executed on ThreadPool.
+ *
+ * Each task added to the graph can declare tasks it depends on. When graph is
+ * run, tasks without dependencies are submitted to the Pool right away and
+ * every other task is submitted as soon as the last of its dependencies
+ * finishes. This way multi-stage jobs do not need a Pool-wide synchronization
+ * point between stages - independent branches of the graph keep worker
+ * threads busy while other branches wait for their inputs.
+ *
+ * Graph can be run multiple times. Graph's structure cannot be modified while
+ * it is running.
+ *
+ * @note Worker which finishes a task continues directly with one of the tasks
+ *       it made runnable, others are submitted to the Pool.
+ */
+class TaskGraph
+{
+public:
+    using NodeID = size_t;
+
+private:
+    struct Node
+    {
+        TaskCallback callback;
+        std::vector<NodeID> successors;
+        uint32_t dependencyCount;
+        std::atomic<uint32_t> pendingDependencies;
+
+        Node(TaskCallback&& cb);
+    };
+
+    using NodeContainer = std::deque<Node>;
+
+    NodeContainer mNodes;
+    ThreadPool* mPool;
+    TaskGroup mTaskGroup;
+
+    bool IsAcyclic() const;
+    void ExecuteNode(NodeID id, ThreadPayload& payload);
+
+public:
+    TaskGraph();
+    ~TaskGraph();
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph(TaskGraph&&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+    TaskGraph& operator=(TaskGraph&&) = delete;
+
+    /**
+     * Adds a task to the graph.
+     *
+     * @p[in] callback     Callback to call when task is executed. Unlike with
+     *                     ThreadPool::AddTask(), callback is kept by the graph
+     *                     and called again on every Run().
+     * @p[in] dependencies Tasks which have to finish before this task starts.
+     *                     All of them must be already present in the graph.
+     * @result ID of added task, to be used as a dependency of other tasks.
+     */
+    NodeID AddTask(TaskCallback&& callback, const std::vector<NodeID>& dependencies = {});
+
+    /**
+     * Makes task @p id wait for task @p dependency to finish.
+     *
+     * @p[in] id         Task which should wait.
+     * @p[in] dependency Task to wait for.
+     *
+     * @result True if dependency was added, false if any of IDs is invalid or
+     *         task would depend on itself.
+     */
+    bool AddDependency(NodeID id, NodeID dependency);
+
+    /**
+     * Starts executing the graph on @p pool. Function does not wait for tasks
+     * to finish, use Wait() for that.
+     *
+     * @p[in] pool Thread Pool to execute tasks on.
+     * @result True if graph was started, false if graph contains a dependency
+     *         cycle and thus could never finish.
+     */
+    bool Run(ThreadPool& pool);
+
+    /**
+     * Waits until all tasks of the graph are finished. Does not wait for other
+     * tasks present in Pool used by Run().
+     */
+    void Wait();
+
+    /**
+     * Removes all tasks from the graph. Graph must not be running.
+     */
+    void Clear();
+
+    /**
+     * Returns amount of tasks in the graph.
+     */
+    LKCOMMON_INLINE size_t GetTaskCount() const
+    {
+        return mNodes.size();
+    }
+};
+
+} // namespace Utils
+} // namespace lkCommon
@@ -5,15 +5,22 @@
  */
 
 #pragma once
+#define _LKCOMMON_UTILS_THREAD_POOL_HPP_
 
 #include <vector>
-#include <queue>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <cstddef>
+#include <limits>
+#include <array>
 
 #include <lkCommon/System/Info.hpp>
+#include <lkCommon/Utils/StaticMPMCQueue.hpp>
 #include <lkCommon/lkCommon.hpp>
 
 
@@ -43,36 +50,468 @@ struct ThreadPayload
  */
 using TaskCallback = std::function<void(ThreadPayload&)>;
 
+/**
+ * Typedef for task called by ThreadPool in bulk. Additional argument is index
+ * of given task in the batch.
+ */
+using IndexedTaskCallback = std::function<void(ThreadPayload&, size_t)>;
+
+namespace Impl {
+
+// Type returned by task callback when called by ThreadPool
+template <typename Callback>
+using TaskResultType = decltype(std::declval<Callback&>()(std::declval<ThreadPayload&>()));
+
+} // namespace Impl
+
+class ThreadPool;
+
+/**
+ * Group of tasks which can be waited for independently from other tasks
+ * present in ThreadPool.
+ *
+ * Group counts tasks which were added to it with ThreadPool::AddTask() or
+ * ThreadPool::AddTasks() and did not finish yet. Use ThreadPool::WaitForTasks()
+ * overload taking a TaskGroup to wait only for tasks of this group. One group
+ * can be reused for multiple submission batches.
+ *
+ * @warning Group must outlive all tasks added to it. Destroying a group while
+ *          its tasks are still pending results in undefined behavior.
+ */
+class TaskGroup
+{
+    friend class ThreadPool;
+
+    std::atomic<size_t> mPendingTasks;
+
+    void AddPendingTasks(size_t count);
+    // returns true if finished task was the last pending one
+    bool FinishTask();
+
+public:
+    TaskGroup();
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup(TaskGroup&&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    TaskGroup& operator=(TaskGroup&&) = delete;
+
+    /**
+     * Returns amount of tasks in group which did not finish yet.
+     */
+    LKCOMMON_INLINE size_t GetPendingTaskCount() const
+    {
+        return mPendingTasks.load();
+    }
+
+    /**
+     * Returns true if all tasks added to group are finished.
+     */
+    LKCOMMON_INLINE bool IsDone() const
+    {
+        return GetPendingTaskCount() == 0;
+    }
+};
+
 /**
  * Structure representing a task to be executed on a separate thread.
  *
- * Task is non-copyable to prevent
+ * Task stores its callable object inline, in a fixed-size buffer, so creating
+ * and moving tasks around does not allocate memory. Only callables bigger than
+ * INLINE_STORAGE_SIZE bytes (or ones which can throw when moved) are allocated
+ * on heap. To stay allocation-free, keep task's captures small - ex. capture
+ * pointers/references to bigger data instead of copying it.
+ *
+ * Task is non-copyable to prevent copying captured state by accident.
  */
 struct Task
 {
-    TaskCallback function;
+    static const size_t INLINE_STORAGE_SIZE = 64;
+
+private:
+    using Storage = typename std::aligned_storage<INLINE_STORAGE_SIZE, alignof(std::max_align_t)>::type;
+    using InvokeFunction = void(*)(void* callable, ThreadPayload& payload);
+    // moves callable from src to dst and destroys src; only destroys src if dst is null
+    using RelocateFunction = void(*)(void* dst, void* src);
+
+    template <typename Callable>
+    struct InlineCallable;
+    template <typename Callable>
+    struct HeapCallable;
+
+    Storage mStorage;
+    InvokeFunction mInvoke;
+    RelocateFunction mRelocate;
+
+    void MoveFrom(Task& other);
+
+    template <typename Callable, typename Callback>
+    void Construct(Callback&& callback, std::true_type fitsInline);
+    template <typename Callable, typename Callback>
+    void Construct(Callback&& callback, std::false_type fitsInline);
+
+public:
+    TaskGroup* group;
+    uint64_t submitTime; // in nanoseconds, zero if Pool statistics are disabled
 
     Task();
-    Task(TaskCallback&& callback);
-    ~Task() = default;
+    template <typename Callback,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<Callback>::type, Task>::value
+              >::type>
+    Task(Callback&& callback, TaskGroup* taskGroup = nullptr);
+    ~Task();
 
     Task(const Task& other) = delete;
     Task& operator=(const Task& other) = delete;
-    Task(Task&& other) = default;
-    Task& operator=(Task&& other) = default;
+    Task(Task&& other) noexcept;
+    Task& operator=(Task&& other) noexcept;
+
+    /**
+     * Calls task's callable object.
+     */
+    LKCOMMON_INLINE void operator()(ThreadPayload& payload)
+    {
+        mInvoke(&mStorage, payload);
+    }
+
+    /**
+     * Destroys task's callable object, leaving the Task empty.
+     */
+    void Reset();
+
+    /**
+     * Returns true if Task does not contain a callable object.
+     */
+    LKCOMMON_INLINE bool IsEmpty() const
+    {
+        return mInvoke == nullptr;
+    }
+
+    /**
+     * Returns true if callable object of type @p Callable fits in Task's
+     * inline storage and will not require a heap allocation.
+     */
+    template <typename Callable>
+    static constexpr bool FitsInline()
+    {
+        return (sizeof(Callable) <= sizeof(Storage)) &&
+               (alignof(Callable) <= alignof(Storage)) &&
+               std::is_nothrow_move_constructible<Callable>::value;
+    }
+};
+
+/**
+ * Double-ended ring buffer of Tasks, used as worker thread's local queue.
+ *
+ * Storage is allocated upfront and reused, so pushing and popping Tasks does
+ * not allocate memory. Buffer doubles its capacity only when it gets full.
+ *
+ * @note TaskQueue is not thread-safe on its own.
+ */
+class TaskQueue
+{
+    std::vector<Task> mTasks;
+    size_t mHead;
+    size_t mSize;
+
+    void Grow();
+
+public:
+    /**
+     * Creates a queue with space for @p capacity Tasks. Capacity is rounded up
+     * to the next power of two.
+     */
+    TaskQueue(size_t capacity);
+
+    void PushBack(Task&& task);
+    bool PopFront(Task& task);
+    bool PopBack(Task& task);
+
+    LKCOMMON_INLINE bool IsEmpty() const
+    {
+        return mSize == 0;
+    }
+
+    LKCOMMON_INLINE size_t Size() const
+    {
+        return mSize;
+    }
+
+    LKCOMMON_INLINE size_t Capacity() const
+    {
+        return mTasks.size();
+    }
+};
+
+/**
+ * Result of a task, which will become available once the task is finished.
+ *
+ * Returned by ThreadPool::AddTask() overload taking a callback which returns a
+ * value. Allows to wait exactly for the task producing needed result, without
+ * synchronizing with the whole Pool. Future can be copied - all copies refer
+ * to the same result.
+ *
+ * @note Future can be destroyed before its task finishes. Task will still be
+ *       executed, but its result will be discarded.
+ */
+template <typename T>
+class TaskFuture
+{
+    friend class ThreadPool;
+
+    struct State
+    {
+        TaskGroup group;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type result;
+        bool hasResult;
+
+        State();
+        ~State();
+
+        template <typename Callback>
+        void Execute(Callback& callback, ThreadPayload& payload);
+    };
+
+    ThreadPool* mPool;
+    std::shared_ptr<State> mState;
+
+    TaskFuture(ThreadPool* pool, const std::shared_ptr<State>& state);
+
+public:
+    /**
+     * Creates an empty future, not associated with any task.
+     */
+    TaskFuture();
+
+    /**
+     * Returns true if future is associated with a task.
+     */
+    bool IsValid() const;
+
+    /**
+     * Returns true if task finished and its result is ready to acquire.
+     */
+    bool IsReady() const;
+
+    /**
+     * Waits for task to finish. Does not wait for any other task in Pool.
+     */
+    void Wait();
+
+    /**
+     * Waits for task to finish and returns its result.
+     *
+     * @result Reference to result returned by task's callback. Reference is
+     *         valid as long as any copy of this future exists.
+     */
+    T& Get();
+};
+
+/**
+ * Priority of a task added to ThreadPool.
+ *
+ * Idle worker threads always pick tasks of higher priority first, both from
+ * their own queues and when stealing from other workers. To prevent lower
+ * priorities from starving under constant stream of more important tasks, a
+ * worker which skipped a queued lower-priority task
+ * ThreadPool::PRIORITY_AGING_LIMIT times in a row picks it up anyway.
+ */
+enum class TaskPriority: unsigned char
+{
+    HIGH = 0,
+    NORMAL,
+    LOW,
+};
+
+static const size_t TASK_PRIORITY_COUNT = 3;
+
+/**
+ * Placement of ThreadPool's worker threads on logical processors.
+ *
+ * NONE leaves scheduling of worker threads to the OS. PHYSICAL_CORES pins
+ * each worker to one logical processor, taking one processor of every
+ * physical core first and moving to SMT siblings only when all physical cores
+ * are taken. NUMA_NODES selects processors the same way, but additionally
+ * gives workers on the same NUMA node consecutive thread IDs and makes them
+ * steal tasks from each other before reaching to other nodes.
+ */
+enum class WorkerAffinity: unsigned char
+{
+    NONE = 0,
+    PHYSICAL_CORES,
+    NUMA_NODES,
+};
+
+/**
+ * Describes how ThreadPool's worker thread behaves when it runs out of tasks.
+ *
+ * Idle worker first busy-waits for @p spinCount iterations, hinting the CPU
+ * with a pause instruction, then gives up its time slice @p yieldCount times
+ * and only after that goes to sleep. Worker which picks up a new task while
+ * still spinning or yielding does not have to be woken up by the OS, which
+ * saves tens of microseconds per task on bursty workloads. Sleeping workers
+ * use no CPU time at all.
+ *
+ * Setting both counts to zero makes workers go to sleep right away.
+ */
+struct WorkerIdlePolicy
+{
+    static const uint32_t DEFAULT_SPIN_COUNT = 2048;
+    static const uint32_t DEFAULT_YIELD_COUNT = 16;
+
+    uint32_t spinCount;
+    uint32_t yieldCount;
+
+    WorkerIdlePolicy()
+        : spinCount(DEFAULT_SPIN_COUNT)
+        , yieldCount(DEFAULT_YIELD_COUNT)
+    {
+    }
+
+    WorkerIdlePolicy(uint32_t spin, uint32_t yield)
+        : spinCount(spin)
+        , yieldCount(yield)
+    {
+    }
 };
 
+/**
+ * Histogram of durations measured by ThreadPool, with power-of-two buckets.
+ *
+ * Bucket 0 counts durations shorter than 1 microsecond, bucket i counts
+ * durations in range [2^(i-1), 2^i) microseconds. Last bucket additionally
+ * counts all durations which are even longer.
+ */
+struct DurationHistogram
+{
+    static const size_t BUCKET_COUNT = 24;
+
+    std::array<uint64_t, BUCKET_COUNT> buckets;
+    uint64_t count;
+    uint64_t totalNanoseconds;
+    uint64_t maxNanoseconds;
+
+    DurationHistogram();
+
+    /**
+     * Returns index of bucket which counts duration of @p nanoseconds.
+     */
+    static size_t GetBucket(uint64_t nanoseconds);
+
+    /**
+     * Returns upper bound of durations counted by bucket @p bucket, in
+     * microseconds.
+     */
+    static uint64_t GetBucketUpperBound(size_t bucket);
+
+    /**
+     * Returns average duration in nanoseconds, or zero if histogram is empty.
+     */
+    uint64_t GetAverageNanoseconds() const;
+
+    /**
+     * Returns estimated @p percentile (in range [0, 100]) of durations, in
+     * microseconds. Estimation is an upper bound of bucket which contains
+     * requested percentile.
+     */
+    uint64_t GetPercentile(double percentile) const;
+};
+
+/**
+ * Statistics of a single ThreadPool worker thread.
+ */
+struct WorkerStatistics
+{
+    uint64_t tasksExecuted;
+    uint64_t busyNanoseconds; // time spent executing tasks
+    uint64_t idleNanoseconds; // time spent looking for tasks, spinning or sleeping
+
+    WorkerStatistics();
+
+    /**
+     * Returns fraction of time worker spent executing tasks, in range [0, 1].
+     */
+    double GetUtilization() const;
+};
+
+/**
+ * Snapshot of statistics gathered by ThreadPool.
+ *
+ * @sa ThreadPool::EnableStatistics()
+ */
+struct ThreadPoolStatistics
+{
+    uint64_t tasksSubmitted;
+    uint64_t tasksCompleted;
+    size_t queueHighWaterMark;          // max amount of queued tasks at once
+    DurationHistogram queueLatency;     // time from adding task to starting it
+    DurationHistogram runTime;          // time of executing task's callback
+    std::vector<WorkerStatistics> workers; // indexed by worker's tid
+    WorkerStatistics externalThreads;   // tasks executed by threads waiting on Pool
+
+    ThreadPoolStatistics();
+};
+
+namespace Impl {
+
+// Statistics of one thread executing tasks, updated only with relaxed atomics
+struct ThreadStatistics
+{
+    std::atomic<uint64_t> tasksExecuted;
+    std::atomic<uint64_t> busyNanoseconds;
+    std::atomic<uint64_t> idleNanoseconds;
+    std::atomic<uint64_t> idleSince; // zero when thread is not idle
+    std::array<std::atomic<uint64_t>, DurationHistogram::BUCKET_COUNT> queueLatency;
+    std::array<std::atomic<uint64_t>, DurationHistogram::BUCKET_COUNT> runTime;
+    std::atomic<uint64_t> queueLatencyTotal;
+    std::atomic<uint64_t> queueLatencyMax;
+    std::atomic<uint64_t> runTimeTotal;
+    std::atomic<uint64_t> runTimeMax;
+
+    ThreadStatistics();
+
+    void Reset(uint64_t now);
+    void RecordTask(uint64_t submitTime, uint64_t startTime, uint64_t endTime);
+    void BeginIdle(uint64_t now);
+    void EndIdle(uint64_t now);
+    void CancelIdle();
+    void Collect(ThreadPoolStatistics& stats, WorkerStatistics& worker, uint64_t now) const;
+};
+
+} // namespace Impl
+
 /**
  * Internal representation of a thread with all its required elements
+ *
+ * Each worker owns a local task deque per TaskPriority level. Worker takes
+ * tasks from the front of its own deques, while other idle workers steal from
+ * their back.
+ *
+ * Thread objects are never destroyed while Pool exists - a worker retired by
+ * ThreadPool::SetWorkerThreadCount() leaves its Thread behind, so others can
+ * still safely look into its deques.
  */
 struct Thread
 {
+    static const size_t DEFAULT_TASK_QUEUE_CAPACITY = 1024;
+    static const uint32_t NO_CPU = std::numeric_limits<uint32_t>::max();
+
     std::thread thread;
-    Task assignedTask;
     ThreadPayload payload;
-    bool taskReady;
-    std::mutex stateMutex;
-    std::condition_variable taskReadyCV;
+    std::array<TaskQueue, TASK_PRIORITY_COUNT> tasks; // indexed by TaskPriority
+    std::mutex tasksMutex;
+    // sizes of deques in tasks, readable without taking tasksMutex
+    std::array<std::atomic<size_t>, TASK_PRIORITY_COUNT> queuedTasks;
+    // amount of tasks picked since last time a queued task of given priority
+    // was picked, used only by the worker itself
+    std::array<uint32_t, TASK_PRIORITY_COUNT> skippedPicks;
+
+    uint32_t cpu;       // logical processor worker is pinned to, NO_CPU if not pinned
+    uint32_t numaNode;
+    std::atomic<bool> retired; // set under Pool's state mutex when worker should leave
+    Impl::ThreadStatistics statistics;
 
     Thread();
     ~Thread();
@@ -83,42 +522,127 @@ struct Thread
  *
  * Main purpose of this utility is to allow performing independent tasks while
  * maximizing CPU usage. By default, the module initializes with amount of
- * threads matching logical CPU count in the system.
+ * threads matching logical CPU count in the system. Amount of threads can be
+ * later changed at runtime with SetWorkerThreadCount().
  *
- * The pool spawns one dispatcher thread responsible for assigning tasks and
- * N worker threads to perform Tasks provided by user. Tasks added by user are
- * enqueued and performed in a FIFO basis. There is no dependency mechanism
- * provided and tasks are not synchronized between each other. If tasks happen
- * to share a common resource, it is user's duty to ensure there is
- * no race/synchronization issues while accessing it.
+ * The pool spawns N worker threads to perform Tasks provided by user. There is
+ * no central dispatcher - each worker has its own task deque. Single tasks
+ * added from outside of the pool go to a lock-free submission queue shared by
+ * all workers (and are spread across workers' deques in a round-robin fashion
+ * only when it is full), batches of tasks are split between workers' deques,
+ * while tasks added from inside of a running task land in deque of the worker
+ * which executes it. A worker which runs out of own tasks checks the
+ * submission queue, then steals from other workers' deques, and when there is
+ * nothing left to steal, idles according to WorkerIdlePolicy before going to
+ * sleep.
+ *
+ * Tasks are started roughly in order of submission, but there is no strict
+ * FIFO guarantee between tasks landing in different deques. Each task has a
+ * TaskPriority (NORMAL by default) - queued tasks of higher priority are
+ * started before ones of lower priority. Tasks added
+ * directly to the Pool are not synchronized between each other - for tasks
+ * depending on results of other tasks use TaskGraph. If tasks happen to share
+ * a common resource, it is user's duty to ensure there is no
+ * race/synchronization issues while accessing it.
  */
 class ThreadPool
 {
-    using ThreadContainer = std::vector<Thread>;
-    using TaskContainer = std::queue<Task>;
+    using ThreadContainer = std::vector<std::unique_ptr<Thread>>;
     using LockGuard = std::lock_guard<std::mutex>;
     using UniqueLock = std::unique_lock<std::mutex>;
 
-    std::condition_variable mDispatchThreadCV;
+    // capacity of lock-free queue for tasks added from outside of the pool,
+    // per TaskPriority level
+    static const size_t SUBMISSION_QUEUE_SIZE = 256;
+    using SubmissionQueue = StaticMPMCQueue<Task, SUBMISSION_QUEUE_SIZE>;
+
     bool mExitFlag;
+    WorkerAffinity mAffinity;
 
-    std::thread mDispatchThread;
-    uint32_t mAvailableWorkerThreads;
+    uint32_t mStartedWorkerThreads;
+    // MAX_WORKER_THREADS slots, Threads are created on demand and never removed
     ThreadContainer mWorkerThreads;
+    // amount of slots in mWorkerThreads which contain a Thread
+    std::atomic<size_t> mCreatedWorkerThreads;
+    // amount of running workers, they always occupy first slots
+    std::atomic<size_t> mWorkerThreadCount;
+    // serializes SetWorkerThreadCount() calls
+    std::mutex mResizeMutex;
+
+    // tasks added from outside of the pool, indexed by TaskPriority
+    std::array<SubmissionQueue, TASK_PRIORITY_COUNT> mSubmittedTasks;
+    // amount of tasks sitting in workers' deques and in mSubmittedTasks, not
+    // yet picked up
+    std::atomic<size_t> mQueuedTasks;
+    // same as above, split per TaskPriority level
+    std::array<std::atomic<size_t>, TASK_PRIORITY_COUNT> mQueuedTasksByPriority;
+    // amount of tasks which were added, but did not finish yet
+    std::atomic<size_t> mActiveTasks;
+    // amount of tasks which are blocked inside of one of WaitForTasks() calls
+    std::atomic<size_t> mSuspendedTasks;
+    // amount of workers sleeping on mTaskAvailableCV
+    std::atomic<size_t> mSleepingWorkerThreads;
+    // amount of threads sleeping on mTasksDoneCV inside of WaitForTasks()
+    std::atomic<size_t> mWaitingThreads;
+    // round-robin counter selecting deque for tasks added outside of the pool
+    std::atomic<size_t> mNextWorkerThread;
+    // WorkerIdlePolicy, kept in atomics so it can be changed while running
+    std::atomic<uint32_t> mIdleSpinCount;
+    std::atomic<uint32_t> mIdleYieldCount;
+
+    std::atomic<bool> mStatisticsEnabled;
+    std::atomic<uint64_t> mTasksSubmitted;
+    std::atomic<size_t> mQueueHighWaterMark;
+    // tasks executed by non-worker threads helping in WaitForTasks()
+    Impl::ThreadStatistics mExternalThreadStatistics;
 
     std::mutex mPoolStateMutex;
     std::condition_variable mStartupStateCV;
+    std::condition_variable mTaskAvailableCV;
     std::condition_variable mTasksDoneCV;
-    TaskContainer mTaskQueue;
 
-    void SpawnThreads();
-    void DispatchThreadFunction();
+    void SpawnThreads(size_t first, size_t last);
+    void RetireThreads(size_t first, size_t last);
+    void PlaceThreads(size_t first, size_t last);
     void WorkerThreadFunction(Thread& t);
+    bool WaitForQueuedTasks(Thread& self);
+    size_t SelectWorkerThread();
+    void PushTask(Task&& task, TaskPriority priority);
+    template <typename TaskGenerator>
+    void PushTasks(size_t count, TaskGroup* group, TaskPriority priority, TaskGenerator&& generator);
+    bool PopTask(Thread* self, Task& task);
+    bool PopTask(Thread* self, Task& task, size_t priority);
+    bool PopSubmittedTask(Task& task, size_t priority);
+    bool PopOwnTask(Thread& self, Task& task);
+    bool StealTask(Thread* self, Task& task, size_t priority);
+    bool StealTask(Thread& victim, Task& task, size_t priority);
+    void SubmitTasks(std::vector<TaskCallback>& callbacks, TaskGroup* group, TaskPriority priority);
+    void SubmitTasks(size_t count, IndexedTaskCallback& callback, TaskGroup* group, TaskPriority priority);
+    void WakeWorkerThreads(size_t count);
+    void ExecuteTask(Task& task, ThreadPayload& payload, Thread* self);
+    void RecordSubmittedTasks(size_t count, size_t queuedTasks);
+    void FinishTask(Task& task);
+    void NotifyWaitingThreads();
+    template <typename Predicate>
+    void WaitUntil(ThreadPayload* helperPayload, Predicate&& isDone);
+    template <typename Predicate>
+    void WaitInsideTask(Predicate&& isDone);
 
 public:
     /**
-     * Default ThreadPool constructor. Spawns dispatcher thread and amount of
-     * worker threads equal to logical CPU count in current system.
+     * Amount of times a worker can pick a task of higher priority over a queued
+     * task of lower priority, before it has to pick the lower-priority one.
+     */
+    static const uint32_t PRIORITY_AGING_LIMIT = 16;
+
+    /**
+     * Upper limit of worker threads one Pool can run.
+     */
+    static const size_t MAX_WORKER_THREADS = 1024;
+
+    /**
+     * Default ThreadPool constructor. Spawns amount of worker threads equal to
+     * logical CPU count in current system.
      *
      * Constructor is left when all worker threads report ready to process
      * tasks.
@@ -126,8 +650,8 @@ public:
     ThreadPool();
 
     /**
-     * Initializes ThreadPool with provided thread count. Spawns dispatcher
-     * thread and @p threads count of worker threads.
+     * Initializes ThreadPool with provided thread count. Spawns @p threads
+     * count of worker threads.
      *
      * Constructor is left when all worker threads report ready to process
      * tasks.
@@ -138,6 +662,23 @@ public:
      */
     ThreadPool(size_t threads);
 
+    /**
+     * Initializes ThreadPool with provided thread count and places worker
+     * threads on logical processors according to @p affinity.
+     *
+     * @p[in] threads  Amount of worker threads to spawn. If equal to zero,
+     *                 logical CPU count available in the system is used.
+     * @p[in] affinity Placement policy for worker threads. If there are more
+     *                 workers than logical processors, placement wraps around.
+     *
+     * Pinning keeps each worker, along with its cache-warm data (ex. user
+     * payload set by SetUserPayloadForThread()), on the same processor. If
+     * OS refuses to pin a worker, it is left unpinned and an error is logged.
+     *
+     * @sa WorkerAffinity
+     */
+    ThreadPool(size_t threads, WorkerAffinity affinity);
+
     /**
      * Destroys Thread Pool. If there are any tasks left to complete, destructor
      * waits for them to finish, signals end of work and joins all threads
@@ -156,20 +697,178 @@ public:
      */
     void SetUserPayloadForThread(uint16_t tid, void* payloadPtr);
 
+    /**
+     * Changes amount of worker threads used by Pool.
+     *
+     * @p[in] threads New amount of worker threads. If equal to zero, logical
+     *                CPU count available in the system is used. Values above
+     *                MAX_WORKER_THREADS are clamped.
+     * @result True on success, false if function was called from inside of
+     *         one of Pool's tasks.
+     *
+     * Pool keeps working while it is resized and no queued task is lost. New
+     * workers get next free thread IDs and are placed according to affinity
+     * policy provided on construction. When shrinking, workers with highest
+     * IDs are retired - each of them finishes tasks already present in its
+     * own deques before it stops, tasks added from outside of the Pool go to
+     * the remaining workers. Function returns when new workers are ready, or
+     * when retired workers are stopped.
+     *
+     * User payload set with SetUserPayloadForThread() stays attached to its
+     * thread ID, also when a retired thread ID is brought back later.
+     *
+     * @note This function is thread-safe, but cannot be called from inside of
+     *       a task of this Pool.
+     */
+    bool SetWorkerThreadCount(size_t threads);
+
+    /**
+     * Sets how worker threads behave when they run out of tasks.
+     *
+     * @p[in] policy New idle policy. Workers which are idling at the moment
+     *               finish their current idle phase using the old policy.
+     *
+     * @sa WorkerIdlePolicy
+     */
+    void SetWorkerIdlePolicy(const WorkerIdlePolicy& policy);
+
+    /**
+     * Returns idle policy currently used by worker threads.
+     */
+    WorkerIdlePolicy GetWorkerIdlePolicy() const;
+
     /**
      * Adds new task to Task queue which will execute @p callback callback.
      *
      * @p[in] callback Callback for task to be called by Thread Pool. Callback
      *                 is moved by this function, so after completing it
      *                 the parameter is left in unspecified state.
+     * @p[in] priority Priority of the task.
      *
      * @note ThreadPool will provide a ThreadPayload object as a parameter for
      *       callback. Thus it is required, that user's callback contains a
      *       ThreadPayload reference argument.
      *
-     * @note This function is thread-safe and can be called by multiple threads.
+     * @note This function is thread-safe and can be called by multiple threads,
+     *       including Pool's own worker threads from inside of a task.
+     */
+    void AddTask(TaskCallback&& callback, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds new task to Task queue and attaches it to @p group.
+     *
+     * @p[in] callback Callback for task to be called by Thread Pool. Moved by
+     *                 this function.
+     * @p[in] group    Group to which task will belong. Can be later used to
+     *                 wait only for tasks of this group.
+     * @p[in] priority Priority of the task.
+     *
+     * @sa AddTask(TaskCallback&&), WaitForTasks(TaskGroup&)
      */
-    void AddTask(TaskCallback&& callback);
+    void AddTask(TaskCallback&& callback, TaskGroup& group,
+                 TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds new task to Task queue which will execute @p callback callback.
+     *
+     * Works the same as AddTask(TaskCallback&&), but @p callback is stored
+     * directly in the Task without converting it to TaskCallback first. As
+     * long as @p callback fits in Task::INLINE_STORAGE_SIZE bytes, adding the
+     * task does not allocate any memory.
+     *
+     * @sa Task
+     */
+    template <typename Callback,
+              typename Result = Impl::TaskResultType<Callback>,
+              typename std::enable_if<std::is_void<Result>::value, int>::type = 0>
+    void AddTask(Callback&& callback, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds new task to Task queue and attaches it to @p group, storing
+     * @p callback directly in the Task.
+     *
+     * @sa AddTask(Callback&&), AddTask(TaskCallback&&, TaskGroup&)
+     */
+    template <typename Callback,
+              typename Result = Impl::TaskResultType<Callback>,
+              typename std::enable_if<std::is_void<Result>::value, int>::type = 0>
+    void AddTask(Callback&& callback, TaskGroup& group, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds new task which produces a value and returns a future to acquire it.
+     *
+     * @p[in] callback Callback for task to be called by Thread Pool. Must be
+     *                 callable as callback(ThreadPayload&) and return a
+     *                 non-void value.
+     * @p[in] priority Priority of the task.
+     * @result Future which will contain value returned by @p callback.
+     *
+     * Waiting on returned future does not require calling WaitForTasks() and
+     * blocks only until this particular task finishes. Future always stores
+     * the result by value - if @p callback returns a reference, referenced
+     * object is copied.
+     *
+     * @note This function is thread-safe and can be called by multiple threads,
+     *       including Pool's own worker threads from inside of a task.
+     */
+    template <typename Callback,
+              typename Result = Impl::TaskResultType<Callback>,
+              typename = typename std::enable_if<!std::is_void<Result>::value>::type>
+    TaskFuture<typename std::decay<Result>::type> AddTask(Callback&& callback, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds a batch of tasks to the Pool, one for each of @p callbacks.
+     *
+     * @p[in] callbacks Callbacks for tasks to be called by Thread Pool. They
+     *                  are moved by this function, so after completing it the
+     *                  collection is left in unspecified state.
+     * @p[in] priority  Priority of all tasks in the batch.
+     *
+     * Tasks are spread across worker threads taking each worker's queue lock
+     * only once and sleeping worker threads are woken up once for the whole
+     * batch. Prefer this over multiple AddTask() calls when submitting lots
+     * of tasks at once.
+     *
+     * @note This function is thread-safe and can be called by multiple threads,
+     *       including Pool's own worker threads from inside of a task.
+     */
+    void AddTasks(std::vector<TaskCallback>&& callbacks, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds a batch of tasks to the Pool and attaches all of them to @p group.
+     *
+     * @sa AddTasks(std::vector<TaskCallback>&&), WaitForTasks(TaskGroup&)
+     */
+    void AddTasks(std::vector<TaskCallback>&& callbacks, TaskGroup& group,
+                  TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds a batch of @p count tasks to the Pool, each calling @p callback
+     * with its index in range [0, @p count).
+     *
+     * @p[in] count    Amount of tasks to add.
+     * @p[in] callback Callback shared by all tasks in the batch. Callback is
+     *                 moved by this function, so after completing it the
+     *                 parameter is left in unspecified state.
+     * @p[in] priority Priority of all tasks in the batch.
+     *
+     * Works the same way as AddTasks() taking a collection of callbacks, but
+     * does not require user to create one callback object per task.
+     *
+     * @note This function is thread-safe and can be called by multiple threads,
+     *       including Pool's own worker threads from inside of a task.
+     */
+    void AddTasks(size_t count, IndexedTaskCallback&& callback,
+                  TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * Adds a batch of @p count indexed tasks to the Pool and attaches all of
+     * them to @p group.
+     *
+     * @sa AddTasks(size_t, IndexedTaskCallback&&), WaitForTasks(TaskGroup&)
+     */
+    void AddTasks(size_t count, IndexedTaskCallback&& callback, TaskGroup& group,
+                  TaskPriority priority = TaskPriority::NORMAL);
 
     /**
      * Waits for task queue to empty and for worker threads to finish executing
@@ -177,9 +876,109 @@ public:
      *
      * After exiting this function user can be sure there is no more tasks left
      * to perform in queue and all worker threads are in idle state.
+     *
+     * When called from inside of a task, calling worker does not block, but
+     * executes queued tasks until there is nothing left to do. In such case
+     * the function waits for all tasks except ones which are themselves
+     * blocked in one of WaitForTasks() calls, including the calling task.
      */
     void WaitForTasks();
 
+    /**
+     * Waits for task queue to empty, executing queued tasks on calling thread
+     * in the meantime.
+     *
+     * @p[in] payload Payload provided to tasks executed by calling thread.
+     *
+     * Calling thread becomes an additional worker for the duration of the
+     * wait, so no CPU time is wasted on blocking. Once there is nothing left
+     * to take from the queues, the thread sleeps until remaining tasks finish
+     * or new tasks are added.
+     *
+     * @note Tasks executed by calling thread receive @p payload instead of
+     *       payload of one of worker threads. Make sure tasks relying on
+     *       ThreadPayload can handle it (ex. by checking its tid).
+     */
+    void WaitForTasks(ThreadPayload& payload);
+
+    /**
+     * Waits only for tasks attached to @p group to finish.
+     *
+     * @p[in] group Group of tasks to wait for.
+     *
+     * Unlike WaitForTasks(), this function does not wait for tasks which do
+     * not belong to @p group, so multiple users of one Pool do not block each
+     * other. After exiting this function all tasks of @p group are finished,
+     * but other tasks might still be queued or executing.
+     *
+     * When called from inside of a task, calling worker executes other queued
+     * tasks while waiting, so tasks can safely wait for groups (and
+     * TaskFutures) of tasks they spawned.
+     */
+    void WaitForTasks(TaskGroup& group);
+
+    /**
+     * Waits only for tasks attached to @p group to finish, executing queued
+     * tasks on calling thread in the meantime.
+     *
+     * @p[in] group   Group of tasks to wait for.
+     * @p[in] payload Payload provided to tasks executed by calling thread.
+     *
+     * @note Calling thread can pick up any queued task, not only ones attached
+     *       to @p group.
+     *
+     * @sa WaitForTasks(ThreadPayload&)
+     */
+    void WaitForTasks(TaskGroup& group, ThreadPayload& payload);
+
+    /**
+     * Enables or disables gathering statistics of Pool's work.
+     *
+     * @p[in] enable True to start gathering statistics, false to stop.
+     *
+     * Statistics are disabled by default. When enabled, each task costs two
+     * extra reads of a monotonic clock and a few uncontended atomic
+     * increments, so they can be left enabled in production. Statistics
+     * gathered so far are kept when disabling - use ResetStatistics() to
+     * clear them. Idle periods in progress are dropped when disabling.
+     *
+     * @sa GetStatistics()
+     */
+    void EnableStatistics(bool enable);
+
+    /**
+     * Returns true if Pool gathers statistics.
+     */
+    LKCOMMON_INLINE bool IsStatisticsEnabled() const
+    {
+        return mStatisticsEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns snapshot of statistics gathered since Pool's creation or since
+     * last ResetStatistics() call.
+     *
+     * Snapshot is not atomic - when taken while Pool is busy, its counters
+     * can be off by tasks which are in progress.
+     *
+     * @note Time of a task which executes other tasks while waiting inside of
+     *       WaitForTasks() includes run time of these tasks.
+     */
+    ThreadPoolStatistics GetStatistics() const;
+
+    /**
+     * Clears all gathered statistics.
+     */
+    void ResetStatistics();
+
+    /**
+     * Returns ThreadPayload of Pool's worker thread which calls this function.
+     *
+     * @result Pointer to calling worker's payload, or nullptr if function was
+     *         not called from one of this Pool's worker threads.
+     */
+    ThreadPayload* GetCurrentWorkerPayload() const;
+
     /**
      * Returns worker thread count which is currently used by Pool.
      *
@@ -187,9 +986,24 @@ public:
      */
     LKCOMMON_INLINE size_t GetWorkerThreadCount() const
     {
-        return mWorkerThreads.size();
+        return mWorkerThreadCount.load();
+    }
+
+    /**
+     * Returns ID of logical processor worker thread @p tid was assigned to.
+     *
+     * @p[in] tid ID of worker thread, lower than GetWorkerThreadCount().
+     * @result Logical processor ID, or Thread::NO_CPU if worker is not pinned.
+     */
+    LKCOMMON_INLINE uint32_t GetWorkerThreadCPU(uint16_t tid) const
+    {
+        LKCOMMON_ASSERT(tid < GetWorkerThreadCount(), "Provided TID is too high - thread does not exist");
+
+        return mWorkerThreads[tid]->cpu;
     }
 };
 
 } // namespace Utils
 } // namespace lkCommon
+
+#include "ThreadPoolImpl.hpp"
@@ -0,0 +1,191 @@
+/**
+ * @file
+ * @author LKostyra (costyrra.xl@gmail.com)
+ * @brief  Thread Pool template definitions
+ */
+
+#pragma once
+
+#ifndef _LKCOMMON_UTILS_THREAD_POOL_HPP_
+#error "Please include main header of ThreadPool, not the implementation header."
+#endif // _LKCOMMON_UTILS_THREAD_POOL_HPP_
+
+
+namespace lkCommon {
+namespace Utils {
+
+template <typename Callable>
+struct Task::InlineCallable
+{
+    static void Invoke(void* callable, ThreadPayload& payload)
+    {
+        (*reinterpret_cast<Callable*>(callable))(payload);
+    }
+
+    static void Relocate(void* dst, void* src)
+    {
+        Callable* srcCallable = reinterpret_cast<Callable*>(src);
+        if (dst != nullptr)
+        {
+            new (dst) Callable(std::move(*srcCallable));
+        }
+        srcCallable->~Callable();
+    }
+};
+
+template <typename Callable>
+struct Task::HeapCallable
+{
+    // storage keeps only a pointer to heap-allocated callable
+    static void Invoke(void* callable, ThreadPayload& payload)
+    {
+        (**reinterpret_cast<Callable**>(callable))(payload);
+    }
+
+    static void Relocate(void* dst, void* src)
+    {
+        Callable** srcCallable = reinterpret_cast<Callable**>(src);
+        if (dst != nullptr)
+        {
+            *reinterpret_cast<Callable**>(dst) = *srcCallable;
+        }
+        else
+        {
+            delete *srcCallable;
+        }
+        *srcCallable = nullptr;
+    }
+};
+
+template <typename Callable, typename Callback>
+void Task::Construct(Callback&& callback, std::true_type)
+{
+    new (&mStorage) Callable(std::forward<Callback>(callback));
+    mInvoke = &InlineCallable<Callable>::Invoke;
+    mRelocate = &InlineCallable<Callable>::Relocate;
+}
+
+template <typename Callable, typename Callback>
+void Task::Construct(Callback&& callback, std::false_type)
+{
+    *reinterpret_cast<Callable**>(&mStorage) = new Callable(std::forward<Callback>(callback));
+    mInvoke = &HeapCallable<Callable>::Invoke;
+    mRelocate = &HeapCallable<Callable>::Relocate;
+}
+
+template <typename Callback, typename>
+Task::Task(Callback&& callback, TaskGroup* taskGroup)
+    : mStorage()
+    , mInvoke(nullptr)
+    , mRelocate(nullptr)
+    , group(taskGroup)
+    , submitTime(0)
+{
+    using Callable = typename std::decay<Callback>::type;
+    Construct<Callable>(std::forward<Callback>(callback),
+                        std::integral_constant<bool, FitsInline<Callable>()>());
+}
+
+
+template <typename T>
+TaskFuture<T>::State::State()
+    : group()
+    , result()
+    , hasResult(false)
+{
+}
+
+template <typename T>
+TaskFuture<T>::State::~State()
+{
+    if (hasResult)
+    {
+        reinterpret_cast<T*>(&result)->~T();
+    }
+}
+
+template <typename T>
+template <typename Callback>
+void TaskFuture<T>::State::Execute(Callback& callback, ThreadPayload& payload)
+{
+    new (&result) T(callback(payload));
+    hasResult = true;
+}
+
+template <typename T>
+TaskFuture<T>::TaskFuture()
+    : mPool(nullptr)
+    , mState()
+{
+}
+
+template <typename T>
+TaskFuture<T>::TaskFuture(ThreadPool* pool, const std::shared_ptr<State>& state)
+    : mPool(pool)
+    , mState(state)
+{
+}
+
+template <typename T>
+bool TaskFuture<T>::IsValid() const
+{
+    return static_cast<bool>(mState);
+}
+
+template <typename T>
+bool TaskFuture<T>::IsReady() const
+{
+    LKCOMMON_ASSERT(IsValid(), "Future is not associated with any task");
+    return mState->group.IsDone();
+}
+
+template <typename T>
+void TaskFuture<T>::Wait()
+{
+    LKCOMMON_ASSERT(IsValid(), "Future is not associated with any task");
+    mPool->WaitForTasks(mState->group);
+}
+
+template <typename T>
+T& TaskFuture<T>::Get()
+{
+    Wait();
+    return *reinterpret_cast<T*>(&mState->result);
+}
+
+
+template <typename Callback, typename Result,
+          typename std::enable_if<std::is_void<Result>::value, int>::type>
+void ThreadPool::AddTask(Callback&& callback, TaskPriority priority)
+{
+    PushTask(Task(std::forward<Callback>(callback)), priority);
+    WakeWorkerThreads(1);
+}
+
+template <typename Callback, typename Result,
+          typename std::enable_if<std::is_void<Result>::value, int>::type>
+void ThreadPool::AddTask(Callback&& callback, TaskGroup& group, TaskPriority priority)
+{
+    PushTask(Task(std::forward<Callback>(callback), &group), priority);
+    WakeWorkerThreads(1);
+}
+
+template <typename Callback, typename Result, typename>
+TaskFuture<typename std::decay<Result>::type> ThreadPool::AddTask(Callback&& callback, TaskPriority priority)
+{
+    using Value = typename std::decay<Result>::type;
+    using State = typename TaskFuture<Value>::State;
+
+    // task keeps its own reference to the state, so it can safely finish
+    // even if user already dropped the future
+    std::shared_ptr<State> state = std::make_shared<State>();
+    PushTask(Task([state, cb = std::forward<Callback>(callback)](ThreadPayload& payload) mutable {
+        state->Execute(cb, payload);
+    }, &state->group), priority);
+    WakeWorkerThreads(1);
+
+    return TaskFuture<Value>(this, state);
+}
+
+} // namespace Utils
+} // namespace lkCommon
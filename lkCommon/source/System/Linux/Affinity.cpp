@@ -0,0 +1,79 @@
+#include "lkCommon/System/Affinity.hpp"
+#include "lkCommon/Utils/Logger.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/sysinfo.h>
+#include <cstring>
+
+
+namespace {
+
+struct ProcessAffinity
+{
+    cpu_set_t mask;
+    bool acquired;
+
+    ProcessAffinity()
+    {
+        CPU_ZERO(&mask);
+        acquired = (sched_getaffinity(0, sizeof(mask), &mask) == 0);
+    }
+};
+
+// captured at load time, before any thread could be pinned
+const ProcessAffinity gProcessAffinity;
+
+} // namespace
+
+
+namespace lkCommon {
+namespace System {
+namespace Affinity {
+
+bool PinCurrentThread(uint32_t cpuID)
+{
+    if (cpuID >= CPU_SETSIZE)
+    {
+        LOGE("CPU ID " << cpuID << " exceeds supported CPU count");
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpuID, &set);
+
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0)
+    {
+        LOGE("Failed to pin thread to CPU " << cpuID << ": " << strerror(ret));
+        return false;
+    }
+
+    return true;
+}
+
+bool UnpinCurrentThread()
+{
+    cpu_set_t set = gProcessAffinity.mask;
+    if (!gProcessAffinity.acquired)
+    {
+        // nothing better to restore, let the OS narrow it down to what process can use
+        const int cpuCount = get_nprocs_conf();
+        for (int i = 0; i < cpuCount && i < CPU_SETSIZE; ++i)
+            CPU_SET(i, &set);
+    }
+
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0)
+    {
+        LOGE("Failed to unpin thread: " << strerror(ret));
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Affinity
+} // namespace System
+} // namespace lkCommon
@@ -1,6 +1,58 @@
 #include "lkCommon/System/Info.hpp"
 #include <sys/sysinfo.h>
 #include <unistd.h>
+#include <sched.h>
+#include <dirent.h>
+
+#include <fstream>
+#include <limits>
+#include <string>
+#include <set>
+#include <utility>
+
+
+namespace {
+
+const std::string SYSFS_CPU_PATH = "/sys/devices/system/cpu/cpu";
+const std::string SYSFS_THP_PMD_SIZE_PATH = "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size";
+const std::string PROC_MEMINFO_PATH = "/proc/meminfo";
+
+bool ReadUint(const std::string& path, uint32_t& value)
+{
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    file >> value;
+    return static_cast<bool>(file);
+}
+
+uint32_t FindNUMANode(const std::string& cpuPath)
+{
+    // NUMA-enabled kernels put a "nodeN" link inside CPU's directory
+    uint32_t node = 0;
+    DIR* dir = opendir(cpuPath.c_str());
+    if (dir == nullptr)
+        return node;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        std::string name(entry->d_name);
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos)
+        {
+            node = static_cast<uint32_t>(std::stoul(name.substr(4)));
+            break;
+        }
+    }
+
+    closedir(dir);
+    return node;
+}
+
+} // namespace
+
 
 namespace lkCommon {
 namespace System {
@@ -17,6 +69,80 @@ size_t GetPageSize()
     return static_cast<size_t>(getpagesize());
 }
 
+size_t GetHugePageSize()
+{
+    // transparent huge pages do not need any pages reserved up front, prefer their size
+    std::ifstream thpFile(SYSFS_THP_PMD_SIZE_PATH);
+    size_t size = 0;
+    if (thpFile >> size && size > 0)
+        return size;
+
+    std::ifstream meminfo(PROC_MEMINFO_PATH);
+    std::string key;
+    while (meminfo >> key)
+    {
+        if (key == "Hugepagesize:" && meminfo >> size && size > 0)
+            return size * 1024; // reported in kB
+
+        meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+
+    return GetPageSize();
+}
+
+CPUTopology GetCPUTopology()
+{
+    CPUTopology topology;
+
+    cpu_set_t processMask;
+    CPU_ZERO(&processMask);
+    bool hasMask = (sched_getaffinity(0, sizeof(processMask), &processMask) == 0);
+
+    const uint32_t cpuCount = static_cast<uint32_t>(get_nprocs_conf());
+    for (uint32_t i = 0; i < cpuCount; ++i)
+    {
+        if (hasMask && !CPU_ISSET(i, &processMask))
+            continue;
+
+        const std::string cpuPath = SYSFS_CPU_PATH + std::to_string(i);
+
+        uint32_t online = 1;
+        if (ReadUint(cpuPath + "/online", online) && online == 0)
+            continue;
+
+        LogicalCPU cpu;
+        cpu.id = i;
+        // without sysfs assume every logical CPU is a separate core
+        if (!ReadUint(cpuPath + "/topology/core_id", cpu.core))
+            cpu.core = i;
+        if (!ReadUint(cpuPath + "/topology/physical_package_id", cpu.package))
+            cpu.package = 0;
+        cpu.numaNode = FindNUMANode(cpuPath);
+
+        topology.push_back(cpu);
+    }
+
+    return topology;
+}
+
+size_t GetPhysicalCoreCount()
+{
+    std::set<std::pair<uint32_t, uint32_t>> cores;
+    for (const LogicalCPU& cpu: GetCPUTopology())
+        cores.emplace(cpu.package, cpu.core);
+
+    return cores.size();
+}
+
+size_t GetNUMANodeCount()
+{
+    std::set<uint32_t> nodes;
+    for (const LogicalCPU& cpu: GetCPUTopology())
+        nodes.insert(cpu.numaNode);
+
+    return nodes.size();
+}
+
 
 } // namespace Info
 } // namespace System
@@ -1,8 +1,55 @@
 #include "lkCommon/System/Memory.hpp"
+#include "lkCommon/System/Info.hpp"
 #include <stdlib.h>
+#include <stdint.h>
+#include <sys/mman.h>
 #include <algorithm>
 
 
+namespace {
+
+const int MAP_FLAGS = MAP_PRIVATE | MAP_ANONYMOUS;
+const int MAP_PROTECTION = PROT_READ | PROT_WRITE;
+
+void* MapHugePages(size_t size, size_t hugePageSize)
+{
+#ifdef MAP_HUGETLB
+    // explicit huge pages work only if administrator reserved some
+    if (size % hugePageSize == 0)
+    {
+        void* ptr = mmap(nullptr, size, MAP_PROTECTION, MAP_FLAGS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED)
+            return ptr;
+    }
+#endif // MAP_HUGETLB
+
+    // otherwise map a bit more and cut out part aligned to huge page size, so kernel can back
+    // it with transparent huge pages
+    const size_t pageSize = lkCommon::System::Info::GetPageSize();
+    const size_t mappedSize = size + hugePageSize - pageSize;
+    uint8_t* mapped = reinterpret_cast<uint8_t*>(mmap(nullptr, mappedSize, MAP_PROTECTION, MAP_FLAGS, -1, 0));
+    if (mapped == MAP_FAILED)
+        return nullptr;
+
+    const size_t misalignment = reinterpret_cast<uintptr_t>(mapped) & (hugePageSize - 1);
+    const size_t head = (hugePageSize - misalignment) & (hugePageSize - 1);
+    const size_t tail = mappedSize - head - size;
+    if (head > 0)
+        munmap(mapped, head);
+    if (tail > 0)
+        munmap(mapped + head + size, tail);
+
+#ifdef MADV_HUGEPAGE
+    // failure only means we stay on regular pages
+    madvise(mapped + head, size, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+
+    return mapped + head;
+}
+
+} // namespace
+
+
 namespace lkCommon {
 namespace System {
 namespace Memory {
@@ -12,7 +59,7 @@ void* AlignedAlloc(size_t size, size_t alignment)
     size_t voidPtrSize = sizeof(void*);
     size = ((size % voidPtrSize) == 0) ? size : size + (voidPtrSize - (size % voidPtrSize));
     void* ptr = nullptr;
-    int ret = posix_memalign(&ptr, size, alignment);
+    int ret = posix_memalign(&ptr, alignment, size);
     if (ret != 0)
         return nullptr;
     return ptr;
@@ -23,6 +70,29 @@ void AlignedFree(void* ptr)
     free(ptr);
 }
 
+void* MapMemory(size_t size, bool hugePages)
+{
+    const size_t hugePageSize = Info::GetHugePageSize();
+    if (hugePages && hugePageSize > Info::GetPageSize() && size >= hugePageSize)
+        return MapHugePages(size, hugePageSize);
+
+    void* ptr = mmap(nullptr, size, MAP_PROTECTION, MAP_FLAGS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return nullptr;
+    return ptr;
+}
+
+void UnmapMemory(void* ptr, size_t size)
+{
+    munmap(ptr, size);
+}
+
+void DiscardMemory(void* ptr, size_t size)
+{
+    // private anonymous pages read as zeros after that
+    madvise(ptr, size, MADV_DONTNEED);
+}
+
 } // namespace lkCommon
 } // namespace System
 } // namespace Memory
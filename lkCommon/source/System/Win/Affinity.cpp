@@ -0,0 +1,55 @@
+#include "lkCommon/System/Affinity.hpp"
+#include "lkCommon/Utils/Logger.hpp"
+
+#include <Windows.h>
+
+
+namespace {
+
+const uint32_t CPUS_PER_GROUP = sizeof(KAFFINITY) * 8;
+
+} // namespace
+
+
+namespace lkCommon {
+namespace System {
+namespace Affinity {
+
+bool PinCurrentThread(uint32_t cpuID)
+{
+    GROUP_AFFINITY affinity;
+    ZeroMemory(&affinity, sizeof(affinity));
+    affinity.Group = static_cast<WORD>(cpuID / CPUS_PER_GROUP);
+    affinity.Mask = static_cast<KAFFINITY>(1) << (cpuID % CPUS_PER_GROUP);
+
+    if (!SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr))
+    {
+        LOGE("Failed to pin thread to CPU " << cpuID << ": error " << GetLastError());
+        return false;
+    }
+
+    return true;
+}
+
+bool UnpinCurrentThread()
+{
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+    {
+        LOGE("Failed to acquire process affinity mask: error " << GetLastError());
+        return false;
+    }
+
+    if (SetThreadAffinityMask(GetCurrentThread(), processMask) == 0)
+    {
+        LOGE("Failed to unpin thread: error " << GetLastError());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Affinity
+} // namespace System
+} // namespace lkCommon
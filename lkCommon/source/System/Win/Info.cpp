@@ -2,6 +2,10 @@
 #include "lkCommon/lkCommon.hpp"
 #include <Windows.h>
 
+#include <map>
+#include <set>
+#include <vector>
+
 namespace {
 
 SYSTEM_INFO gSystemInfo;
@@ -16,6 +20,56 @@ LKCOMMON_INLINE void FetchSystemInfo()
     }
 }
 
+template <typename Func>
+void ForEachCPUInMask(const GROUP_AFFINITY& affinity, Func func)
+{
+    for (uint32_t bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit)
+    {
+        if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit))
+            func(affinity.Group * static_cast<uint32_t>(sizeof(KAFFINITY) * 8) + bit);
+    }
+}
+
+// Collects IDs of logical processors current process is allowed to run on
+std::set<uint32_t> GetProcessCPUs()
+{
+    std::set<uint32_t> result;
+
+    USHORT groupCount = 0;
+    GetProcessGroupAffinity(GetCurrentProcess(), &groupCount, nullptr);
+    std::vector<USHORT> groups(groupCount);
+    if (groupCount == 0 || !GetProcessGroupAffinity(GetCurrentProcess(), &groupCount, groups.data()))
+        return result;
+
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (groupCount == 1 && GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) && processMask != 0)
+    {
+        GROUP_AFFINITY affinity;
+        ZeroMemory(&affinity, sizeof(affinity));
+        affinity.Group = groups[0];
+        affinity.Mask = static_cast<KAFFINITY>(processMask);
+        ForEachCPUInMask(affinity, [&](uint32_t id) {
+            result.insert(id);
+        });
+        return result;
+    }
+
+    // process spanning multiple groups has no single mask, it can use all processors of its groups
+    for (USHORT g: groups)
+    {
+        GROUP_AFFINITY affinity;
+        ZeroMemory(&affinity, sizeof(affinity));
+        affinity.Group = g;
+        affinity.Mask = ~static_cast<KAFFINITY>(0);
+        ForEachCPUInMask(affinity, [&](uint32_t id) {
+            result.insert(id);
+        });
+    }
+
+    return result;
+}
+
 } // namespace
 
 namespace lkCommon {
@@ -34,6 +88,102 @@ size_t GetPageSize()
     return gSystemInfo.dwPageSize;
 }
 
+size_t GetHugePageSize()
+{
+    const SIZE_T largePageSize = GetLargePageMinimum();
+    if (largePageSize == 0)
+        return GetPageSize();
+
+    return largePageSize;
+}
+
+CPUTopology GetCPUTopology()
+{
+    CPUTopology topology;
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+        return topology;
+
+    std::vector<uint8_t> buffer(length);
+    if (!GetLogicalProcessorInformationEx(RelationAll,
+            reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+        return topology;
+
+    std::map<uint32_t, LogicalCPU> cpus;
+    uint32_t coreCounter = 0;
+    uint32_t packageCounter = 0;
+
+    for (DWORD offset = 0; offset < length; )
+    {
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX info =
+            reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+
+        switch (info->Relationship)
+        {
+        case RelationProcessorCore:
+            for (WORD g = 0; g < info->Processor.GroupCount; ++g)
+            {
+                ForEachCPUInMask(info->Processor.GroupMask[g], [&](uint32_t id) {
+                    cpus[id].id = id;
+                    cpus[id].core = coreCounter;
+                });
+            }
+            coreCounter++;
+            break;
+        case RelationProcessorPackage:
+            for (WORD g = 0; g < info->Processor.GroupCount; ++g)
+            {
+                ForEachCPUInMask(info->Processor.GroupMask[g], [&](uint32_t id) {
+                    cpus[id].package = packageCounter;
+                });
+            }
+            packageCounter++;
+            break;
+        case RelationNumaNode:
+            ForEachCPUInMask(info->NumaNode.GroupMask, [&](uint32_t id) {
+                cpus[id].numaNode = info->NumaNode.NodeNumber;
+            });
+            break;
+        default:
+            break;
+        }
+
+        offset += info->Size;
+    }
+
+    // skip processors current process cannot run on, unless they could not be determined
+    const std::set<uint32_t> processCPUs = GetProcessCPUs();
+    for (auto& c: cpus)
+    {
+        if (!processCPUs.empty() && processCPUs.count(c.first) == 0)
+            continue;
+
+        topology.push_back(c.second);
+    }
+
+    return topology;
+}
+
+size_t GetPhysicalCoreCount()
+{
+    std::set<std::pair<uint32_t, uint32_t>> cores;
+    for (const LogicalCPU& cpu: GetCPUTopology())
+        cores.emplace(cpu.package, cpu.core);
+
+    return cores.size();
+}
+
+size_t GetNUMANodeCount()
+{
+    std::set<uint32_t> nodes;
+    for (const LogicalCPU& cpu: GetCPUTopology())
+        nodes.insert(cpu.numaNode);
+
+    return nodes.size();
+}
+
 
 } // namespace Info
 } // namespace System
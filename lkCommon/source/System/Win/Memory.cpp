@@ -1,4 +1,5 @@
 #include "lkCommon/System/Memory.hpp"
+#include "lkCommon/System/Info.hpp"
 #include <malloc.h>
 #include <Windows.h>
 
@@ -17,6 +18,33 @@ void AlignedFree(void* ptr)
     _aligned_free(ptr);
 }
 
+void* MapMemory(size_t size, bool hugePages)
+{
+    const size_t largePageSize = Info::GetHugePageSize();
+    if (hugePages && largePageSize > Info::GetPageSize() && size % largePageSize == 0)
+    {
+        // large pages require SeLockMemoryPrivilege, without it regular pages are used
+        void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (ptr != nullptr)
+            return ptr;
+    }
+
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void UnmapMemory(void* ptr, size_t)
+{
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+void DiscardMemory(void* ptr, size_t size)
+{
+    // committing again does not take physical memory until pages are touched, then they are
+    // zeroed - large pages cannot be decommitted and stay as they are
+    if (VirtualFree(ptr, size, MEM_DECOMMIT))
+        VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
+}
+
 } // namespace lkCommon
 } // namespace System
 } // namespace Memory
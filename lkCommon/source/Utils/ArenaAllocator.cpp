@@ -4,47 +4,506 @@
 #include "lkCommon/Utils/Logger.hpp"
 
 #include <algorithm>
+#include <array>
+#include <limits>
+#include <unordered_map>
 
 
 namespace {
 
 const uint32_t DEAD_AREA_MAGIC = 0xDEADBEEF;
 
-LKCOMMON_INLINE size_t EnsureArenaFitsSize(size_t currentArenaSize, size_t toAllocSize)
+// reference count added to a chunk for each thread cache holding a region of it - bigger than
+// any possible amount of allocations, so chunk is never seen as unused while region is held
+const size_t REGION_HOLD = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 2);
+
+// size of region reserved by thread cache, in system pages
+const size_t THREAD_CACHE_REGION_PAGES = 4;
+
+// amount of allocators a thread remembers its caches for
+const size_t THREAD_CACHE_SLOT_COUNT = 8;
+
+// amount of blocks moved at once between thread's free list and allocator's shared one
+const size_t SIZE_CLASS_BATCH = 32;
+
+// length of thread's free list above which a batch of blocks is moved to allocator
+const size_t SIZE_CLASS_FREE_LIST_LIMIT = SIZE_CLASS_BATCH * 2;
+
+// biggest allocation served from size classes
+const size_t MAX_SIZE_CLASS_ALLOCATION =
+    lkCommon::Utils::Impl::ARENA_SIZE_CLASS_GRANULARITY * lkCommon::Utils::Impl::ARENA_SIZE_CLASS_COUNT;
+
+std::atomic<uint64_t> gNextAllocatorID(1);
+
+/**
+ * Radix tree mapping memory pages to chunks which contain them.
+ *
+ * Chunks of all allocators never overlap, so a single map is shared by all of them. Chunks are
+ * registered page by page when they are added, which makes finding the chunk of any pointer a
+ * constant-time walk through three levels of the tree. Lookups do not lock - nodes are installed
+ * with a CAS and are never freed.
+ *
+ * Pages dedicated to a size class of ArenaAllocatorMode::SMALL_OBJECTS additionally remember
+ * index of their class increased by one, so zero means the page does not belong to any class.
+ */
+class ChunkPageMap
+{
+    // chunks are aligned to system's page size, which is never smaller than that
+    static const size_t PAGE_SHIFT = 12;
+    static const size_t LEVEL_BITS = 12;
+    static const size_t LEVEL_SIZE = static_cast<size_t>(1) << LEVEL_BITS;
+    static const size_t LEVEL_MASK = LEVEL_SIZE - 1;
+    // user-space addresses fit in 48 bits on all supported platforms
+    static const size_t ADDRESS_BITS = PAGE_SHIFT + LEVEL_BITS * 3;
+
+    struct Leaf
+    {
+        std::array<std::atomic<lkCommon::Utils::Arena*>, LEVEL_SIZE> arenas;
+        std::array<std::atomic<uint8_t>, LEVEL_SIZE> sizeClasses;
+
+        Leaf()
+            : arenas()
+            , sizeClasses()
+        {
+        }
+    };
+
+    using Node = std::array<std::atomic<Leaf*>, LEVEL_SIZE>;
+
+    std::array<std::atomic<Node*>, LEVEL_SIZE> mRoot;
+
+    template <typename T>
+    static T* GetOrCreate(std::atomic<T*>& slot)
+    {
+        T* node = slot.load(std::memory_order_acquire);
+        if (node != nullptr)
+        {
+            return node;
+        }
+
+        // other thread might install the node at the same time - loser deletes its own
+        T* newNode = new T();
+        if (slot.compare_exchange_strong(node, newNode, std::memory_order_acq_rel))
+        {
+            return newNode;
+        }
+
+        delete newNode;
+        return node;
+    }
+
+    template <typename Func>
+    void ForEachPage(const uint8_t* begin, size_t size, Func func)
+    {
+        LKCOMMON_ASSERT(Covers(begin, size), "Chunk address out of range of chunk page map");
+
+        const uintptr_t firstPage = reinterpret_cast<uintptr_t>(begin) >> PAGE_SHIFT;
+        const uintptr_t lastPage = (reinterpret_cast<uintptr_t>(begin) + size - 1) >> PAGE_SHIFT;
+        for (uintptr_t page = firstPage; page <= lastPage; ++page)
+        {
+            Node* node = GetOrCreate(mRoot[(page >> (LEVEL_BITS * 2)) & LEVEL_MASK]);
+            Leaf* leaf = GetOrCreate((*node)[(page >> LEVEL_BITS) & LEVEL_MASK]);
+            func(*leaf, page & LEVEL_MASK);
+        }
+    }
+
+    const Leaf* FindLeaf(const void* ptr) const
+    {
+        const uintptr_t page = reinterpret_cast<uintptr_t>(ptr) >> PAGE_SHIFT;
+        if ((page >> (LEVEL_BITS * 3)) != 0)
+        {
+            return nullptr;
+        }
+
+        const Node* node = mRoot[(page >> (LEVEL_BITS * 2)) & LEVEL_MASK].load(std::memory_order_acquire);
+        if (node == nullptr)
+        {
+            return nullptr;
+        }
+
+        return (*node)[(page >> LEVEL_BITS) & LEVEL_MASK].load(std::memory_order_acquire);
+    }
+
+    static size_t GetLeafIndex(const void* ptr)
+    {
+        return (reinterpret_cast<uintptr_t>(ptr) >> PAGE_SHIFT) & LEVEL_MASK;
+    }
+
+public:
+    // higher addresses would wrap around onto pages of other chunks
+    static bool Covers(const uint8_t* begin, size_t size)
+    {
+        const uintptr_t first = reinterpret_cast<uintptr_t>(begin);
+        const uintptr_t last = first + size - 1;
+        return (size > 0) && (last >= first) && ((last >> ADDRESS_BITS) == 0);
+    }
+
+    // registers pages of a chunk, clearing size classes they might have had before
+    bool Set(const uint8_t* begin, size_t size, lkCommon::Utils::Arena* arena)
+    {
+        if (!Covers(begin, size))
+        {
+            return false;
+        }
+
+        ForEachPage(begin, size, [arena](Leaf& leaf, size_t index) {
+            leaf.sizeClasses[index].store(0, std::memory_order_release);
+            leaf.arenas[index].store(arena, std::memory_order_release);
+        });
+        return true;
+    }
+
+    void SetSizeClass(const uint8_t* begin, size_t size, uint8_t sizeClass)
+    {
+        ForEachPage(begin, size, [sizeClass](Leaf& leaf, size_t index) {
+            leaf.sizeClasses[index].store(sizeClass, std::memory_order_release);
+        });
+    }
+
+    lkCommon::Utils::Arena* Get(const void* ptr) const
+    {
+        const Leaf* leaf = FindLeaf(ptr);
+        if (leaf == nullptr)
+        {
+            return nullptr;
+        }
+
+        return leaf->arenas[GetLeafIndex(ptr)].load(std::memory_order_acquire);
+    }
+
+    uint8_t GetSizeClass(const void* ptr) const
+    {
+        const Leaf* leaf = FindLeaf(ptr);
+        if (leaf == nullptr)
+        {
+            return 0;
+        }
+
+        return leaf->sizeClasses[GetLeafIndex(ptr)].load(std::memory_order_acquire);
+    }
+};
+
+// zero-initialized as a static object, so it is usable before any constructor runs
+ChunkPageMap gChunkPageMap;
+
+// amount of bytes to skip from @p ptr to reach an address aligned to @p alignment
+LKCOMMON_INLINE size_t GetPadding(const uint8_t* ptr, size_t alignment)
+{
+    const size_t misalignment = static_cast<size_t>(reinterpret_cast<uintptr_t>(ptr)) & (alignment - 1);
+    return (alignment - misalignment) & (alignment - 1);
+}
+
+// first byte of chunk which was not given out yet
+LKCOMMON_INLINE uint8_t* GetChunkTop(const lkCommon::Utils::Arena& arena)
+{
+    return arena.ptr + (arena.size - arena.sizeLeft);
+}
+
+LKCOMMON_INLINE size_t RoundUp(size_t size, size_t granularity)
 {
-    while (currentArenaSize < toAllocSize)
+    return (size + granularity - 1) / granularity * granularity;
+}
+
+// freed blocks are linked through a pointer placed right after the magic, so double-free
+// detection keeps working for blocks on free lists
+LKCOMMON_INLINE uint8_t*& GetNextFreeBlock(uint8_t* block)
+{
+    return *reinterpret_cast<uint8_t**>(block + sizeof(void*));
+}
+
+LKCOMMON_INLINE void PushFreeBlock(lkCommon::Utils::Impl::ArenaFreeList& list, uint8_t* block)
+{
+    GetNextFreeBlock(block) = list.head;
+    list.head = block;
+    list.count++;
+}
+
+LKCOMMON_INLINE uint8_t* PopFreeBlock(lkCommon::Utils::Impl::ArenaFreeList& list)
+{
+    uint8_t* block = list.head;
+    if (block != nullptr)
     {
-        currentArenaSize *= 2;
+        list.head = GetNextFreeBlock(block);
+        list.count--;
     }
 
-    return currentArenaSize;
+    return block;
+}
+
+void MoveFreeBlocks(lkCommon::Utils::Impl::ArenaFreeList& from, lkCommon::Utils::Impl::ArenaFreeList& to,
+                    size_t count)
+{
+    for (size_t i = 0; i < count && from.head != nullptr; ++i)
+    {
+        PushFreeBlock(to, PopFreeBlock(from));
+    }
+}
+
+// reused block must not look freed, even if user never overwrites its first bytes
+LKCOMMON_INLINE void* ReuseFreeBlock(uint8_t* block)
+{
+    *reinterpret_cast<uint32_t*>(block) = 0;
+    return block;
+}
+
+LKCOMMON_INLINE size_t GetSizeClassBlockSize(size_t sizeClass)
+{
+    return (sizeClass + 1) * lkCommon::Utils::Impl::ARENA_SIZE_CLASS_GRANULARITY;
 }
 
 } // namespace
 
 namespace lkCommon {
 namespace Utils {
+namespace Impl {
+
+// Tracks living allocators, so thread caches can be given back to them when their thread exits
+class ArenaThreadCacheRegistry
+{
+    struct Slot
+    {
+        uint64_t allocatorID;
+        ArenaThreadCache* cache;
+    };
+
+    struct ThreadSlots
+    {
+        std::array<Slot, THREAD_CACHE_SLOT_COUNT> slots;
+        size_t nextSlot;
 
-ArenaAllocator::ArenaAllocator()
-    : mPageSize(lkCommon::System::Info::GetPageSize())
+        ThreadSlots()
+            : slots()
+            , nextSlot(0)
+        {
+        }
+
+        ~ThreadSlots()
+        {
+            ReleaseThreadCaches(*this);
+        }
+    };
+
+    using AllocatorMap = std::unordered_map<uint64_t, ArenaAllocator*>;
+
+    static thread_local ThreadSlots tThreadSlots;
+
+    static std::mutex& GetMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static AllocatorMap& GetAllocators()
+    {
+        static AllocatorMap allocators;
+        return allocators;
+    }
+
+    // must be called with registry's mutex locked
+    static void ReleaseSlot(Slot& s)
+    {
+        if (s.cache == nullptr)
+        {
+            return;
+        }
+
+        // allocator might be gone already, its chunks were freed along with it
+        AllocatorMap& allocators = GetAllocators();
+        auto it = allocators.find(s.allocatorID);
+        if (it != allocators.end())
+        {
+            it->second->ReleaseThreadCache(*s.cache);
+        }
+
+        s.cache = nullptr;
+    }
+
+    static void ReleaseThreadCaches(ThreadSlots& threadSlots)
+    {
+        std::lock_guard<std::mutex> lock(GetMutex());
+
+        for (Slot& s: threadSlots.slots)
+        {
+            ReleaseSlot(s);
+        }
+    }
+
+public:
+    static void Register(ArenaAllocator* allocator)
+    {
+        std::lock_guard<std::mutex> lock(GetMutex());
+        GetAllocators()[allocator->mID] = allocator;
+    }
+
+    static void Unregister(ArenaAllocator* allocator)
+    {
+        std::lock_guard<std::mutex> lock(GetMutex());
+        GetAllocators().erase(allocator->mID);
+    }
+
+    static ArenaThreadCache* FindThreadCache(uint64_t allocatorID)
+    {
+        for (const Slot& s: tThreadSlots.slots)
+        {
+            if (s.cache != nullptr && s.allocatorID == allocatorID)
+            {
+                return s.cache;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // must be called without any allocator's mutex locked, evicted cache is released right away
+    static void InsertThreadCache(uint64_t allocatorID, ArenaThreadCache* cache)
+    {
+        Slot& s = tThreadSlots.slots[tThreadSlots.nextSlot];
+        tThreadSlots.nextSlot = (tThreadSlots.nextSlot + 1) % THREAD_CACHE_SLOT_COUNT;
+
+        {
+            // otherwise its region would be held until allocator is destroyed
+            std::lock_guard<std::mutex> lock(GetMutex());
+            ReleaseSlot(s);
+        }
+
+        s.allocatorID = allocatorID;
+        s.cache = cache;
+    }
+};
+
+thread_local ArenaThreadCacheRegistry::ThreadSlots ArenaThreadCacheRegistry::tThreadSlots;
+
+} // namespace Impl
+
+
+const size_t ArenaGrowthPolicy::NO_LIMIT;
+constexpr float ArenaGrowthPolicy::DEFAULT_GROWTH_FACTOR;
+
+const size_t ArenaAllocator::DEFAULT_ALIGNMENT;
+
+ArenaAllocator::ArenaAllocator(ArenaAllocatorMode mode, ArenaChunkSource chunkSource)
+    : mID(gNextAllocatorID.fetch_add(1))
+    , mMode(mode)
+    , mChunkSource(chunkSource)
+    , mPageSize(lkCommon::System::Info::GetPageSize())
+    , mHugePageSize(lkCommon::System::Info::GetHugePageSize())
+    , mGrowthPolicy()
     , mArenaSize(mPageSize)
+    , mTotalChunkSize(0)
+    , mThreadCacheRegionSize(mPageSize * THREAD_CACHE_REGION_PAGES)
+    , mMaxThreadCacheAllocationSize(mPageSize / 4)
     , mArenas()
+    , mThreadCaches()
+    , mSharedFreeLists()
+    , mGeneration(0)
     , mAllocatorMutex()
 {
+    Impl::ArenaThreadCacheRegistry::Register(this);
 }
 
 ArenaAllocator::~ArenaAllocator()
 {
+    // exiting threads must not touch our caches from now on
+    Impl::ArenaThreadCacheRegistry::Unregister(this);
+
     // free all chunks
     FreeChunks();
 }
 
-Arena* ArenaAllocator::AddChunk()
+size_t ArenaAllocator::RoundChunkSize(size_t size) const
+{
+    // huge pages are worth it only for chunks spanning at least one of them
+    if (mChunkSource == ArenaChunkSource::MAPPED_HUGE_PAGES && size >= mHugePageSize)
+    {
+        return RoundUp(size, mHugePageSize);
+    }
+
+    return RoundUp(size, mPageSize);
+}
+
+size_t ArenaAllocator::GetInitialChunkSize() const
+{
+    if (mGrowthPolicy.initialChunkSize == 0)
+    {
+        return mPageSize;
+    }
+
+    return RoundUp(mGrowthPolicy.initialChunkSize, mPageSize);
+}
+
+size_t ArenaAllocator::GetGrownChunkSize(size_t size) const
 {
-    uint8_t* memory = reinterpret_cast<uint8_t*>(System::Memory::AlignedAlloc(mArenaSize, mPageSize));
+    const double grownSize = static_cast<double>(size) * mGrowthPolicy.growthFactor;
+    if (grownSize >= static_cast<double>(std::numeric_limits<size_t>::max() / 2))
+    {
+        // no allocation could ever use a chunk this big
+        return size;
+    }
+
+    size_t grown = RoundUp(static_cast<size_t>(grownSize), mPageSize);
+    grown = std::max(grown, size);
+
+    if (mGrowthPolicy.maxChunkSize != ArenaGrowthPolicy::NO_LIMIT)
+    {
+        grown = std::min(grown, RoundUp(mGrowthPolicy.maxChunkSize, mPageSize));
+    }
+
+    return grown;
+}
+
+size_t ArenaAllocator::GrowChunkSizeToFit(size_t chunkSize, size_t size) const
+{
+    // stops at max chunk size, bigger allocations get chunks of their own size
+    size_t grown = GetGrownChunkSize(chunkSize);
+    while (chunkSize < size && grown > chunkSize)
+    {
+        chunkSize = grown;
+        grown = GetGrownChunkSize(chunkSize);
+    }
+
+    return chunkSize;
+}
+
+Arena* ArenaAllocator::AddChunk(size_t size, size_t minSize)
+{
+    size_t chunkSize = RoundChunkSize(size);
+
+    const size_t budget = mGrowthPolicy.memoryBudget;
+    if (budget != ArenaGrowthPolicy::NO_LIMIT && mTotalChunkSize + chunkSize > budget)
+    {
+        // make room by dropping chunks nobody uses, then settle for the smallest chunk that fits
+        FreeUnusedChunks();
+        if (mTotalChunkSize + chunkSize > budget)
+        {
+            chunkSize = RoundChunkSize(minSize);
+        }
+
+        if (mTotalChunkSize + chunkSize > budget)
+        {
+            LOGW("Chunk of size " << chunkSize << " would exceed memory budget of " << budget << " bytes");
+            if (mGrowthPolicy.budgetExceededCallback)
+            {
+                mGrowthPolicy.budgetExceededCallback(chunkSize, mTotalChunkSize);
+            }
+
+            return nullptr;
+        }
+    }
+
+    uint8_t* memory = nullptr;
+    if (mChunkSource == ArenaChunkSource::HEAP)
+    {
+        memory = reinterpret_cast<uint8_t*>(System::Memory::AlignedAlloc(chunkSize, mPageSize));
+    }
+    else
+    {
+        const bool hugePages = (mChunkSource == ArenaChunkSource::MAPPED_HUGE_PAGES && chunkSize >= mHugePageSize);
+        memory = reinterpret_cast<uint8_t*>(System::Memory::MapMemory(chunkSize, hugePages));
+    }
+
     if (memory == nullptr)
     {
-        LOGE("Failed to allocate aligned block of memory of size " << mArenaSize);
+        LOGE("Failed to allocate aligned block of memory of size " << chunkSize);
         return nullptr;
     }
 
@@ -52,78 +511,389 @@ Arena* ArenaAllocator::AddChunk()
     Arena* arena = &mArenas.back();
 
     arena->ptr = memory;
-    arena->size = arena->sizeLeft = mArenaSize;
+    arena->size = arena->sizeLeft = chunkSize;
+    if (!gChunkPageMap.Set(arena->ptr, arena->size, arena))
+    {
+        // pointers from such chunk could not be found when freed
+        LOGE("Chunk of size " << chunkSize << " was placed outside of supported address range");
+        FreeChunkMemory(memory, chunkSize);
+        mArenas.pop_back();
+        return nullptr;
+    }
+
+    mTotalChunkSize += chunkSize;
     return arena;
 }
 
+void ArenaAllocator::FreeChunkMemory(uint8_t* memory, size_t size)
+{
+    if (mChunkSource == ArenaChunkSource::HEAP)
+    {
+        System::Memory::AlignedFree(memory);
+    }
+    else
+    {
+        System::Memory::UnmapMemory(memory, size);
+    }
+}
+
+void ArenaAllocator::FreeChunk(Arena& arena)
+{
+    gChunkPageMap.Set(arena.ptr, arena.size, nullptr);
+    FreeChunkMemory(arena.ptr, arena.size);
+
+    mTotalChunkSize -= arena.size;
+    arena.ptr = nullptr;
+}
+
 Arena* ArenaAllocator::FindArenaByPointer(void* ptr)
 {
-    for (auto& a: mArenas)
+    return gChunkPageMap.Get(ptr);
+}
+
+Arena* ArenaAllocator::ReserveChunkSpace(size_t size, size_t alignment)
+{
+    // new chunks are page-aligned, so they need padding only for even bigger alignments
+    const size_t newChunkSize = size + ((alignment > mPageSize) ? (alignment - mPageSize) : 0);
+
+    Arena* arena = nullptr;
+    size_t chunkSize = mArenaSize;
+    if (!mArenas.empty())
     {
-        if (a.ptr <= ptr && ptr < (a.ptr + a.size))
-            return &a;
+        arena = &mArenas.back();
+        ReuseIfUnused(*arena);
+        if (arena->sizeLeft >= GetPadding(GetChunkTop(*arena), alignment) + size)
+        {
+            return arena;
+        }
+
+        chunkSize = GetGrownChunkSize(chunkSize);
+    }
+
+    // increase the size only if we won't fit size bytes of data
+    chunkSize = GrowChunkSizeToFit(chunkSize, newChunkSize);
+    arena = AddChunk(std::max(chunkSize, newChunkSize), newChunkSize);
+    if (arena != nullptr)
+    {
+        // chunk might have been shrunk to fit memory budget, growth continues from its size,
+        // while chunks holding a single oversized allocation do not affect it
+        mArenaSize = std::min(chunkSize, arena->size);
     }
 
-    return nullptr;
+    return arena;
 }
 
-void* ArenaAllocator::Allocate(size_t size)
+void* ArenaAllocator::AllocateFromChunk(size_t size, size_t alignment)
 {
-    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+    Arena* arena = ReserveChunkSpace(size, alignment);
+    if (arena == nullptr)
+    {
+        return nullptr;
+    }
 
-    size = std::max(size, sizeof(uint32_t)); // to ensure we'll be able to fit magic
-    Arena* arena;
+    uint8_t* top = GetChunkTop(*arena);
+    const size_t padding = GetPadding(top, alignment);
+    arena->sizeLeft -= padding + size;
+    arena->referenceCount.fetch_add(1);
+    return top + padding;
+}
 
-    if (mArenas.empty())
+Impl::ArenaThreadCache* ArenaAllocator::GetThreadCache()
+{
+    Impl::ArenaThreadCache* cache = Impl::ArenaThreadCacheRegistry::FindThreadCache(mID);
+    if (cache != nullptr)
+    {
+        return cache;
+    }
+
+    {
+        // thread's cache not found in its slots was never created or was released on eviction
+        std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+        mThreadCaches.emplace_back();
+        cache = &mThreadCaches.back();
+    }
+
+    // cache is used only by this thread, so it stays valid without the lock
+    Impl::ArenaThreadCacheRegistry::InsertThreadCache(mID, cache);
+    return cache;
+}
+
+void* ArenaAllocator::AllocateFromNewRegion(Impl::ArenaThreadCache& cache, size_t size, size_t alignment)
+{
+    ReleaseRegion(cache);
+
+    Arena* arena = ReserveChunkSpace(size, alignment);
+    if (arena == nullptr)
+    {
+        return nullptr;
+    }
+
+    // region starts right at the address we need
+    uint8_t* top = GetChunkTop(*arena);
+    const size_t padding = GetPadding(top, alignment);
+    arena->sizeLeft -= padding;
+
+    const size_t regionSize = std::min(std::max(mThreadCacheRegionSize, size), arena->sizeLeft);
+    uint8_t* region = top + padding;
+    arena->sizeLeft -= regionSize;
+    arena->referenceCount.fetch_add(REGION_HOLD);
+
+    cache.arena = arena;
+    cache.current = region + size;
+    cache.end = region + regionSize;
+    cache.lastAllocation = region;
+    cache.lastAllocationStart = region;
+    cache.allocationCount = 1;
+    cache.generation = mGeneration.load();
+    return region;
+}
+
+void ArenaAllocator::ReleaseRegion(Impl::ArenaThreadCache& cache)
+{
+    // region from before FreeChunks() points to memory which is already gone
+    if (cache.arena != nullptr && cache.generation == mGeneration.load())
     {
-        // increase the size only if we won't fit size bytes of data
-        mArenaSize = EnsureArenaFitsSize(mArenaSize, size);
-        arena = AddChunk();
-        if (arena == nullptr)
+        Arena& arena = *cache.arena;
+
+        // give unused part back if nothing was reserved after the region
+        if (cache.end == GetChunkTop(arena))
         {
-            return nullptr;
+            arena.sizeLeft += static_cast<size_t>(cache.end - cache.current);
         }
+
+        // replace region hold with region's allocations in one go, wraps around for unsigned
+        // type, which is fine
+        arena.referenceCount.fetch_sub(REGION_HOLD - cache.allocationCount);
     }
-    else
+
+    cache.arena = nullptr;
+    cache.current = nullptr;
+    cache.end = nullptr;
+    cache.lastAllocation = nullptr;
+    cache.lastAllocationStart = nullptr;
+    cache.allocationCount = 0;
+}
+
+void ArenaAllocator::ReleaseThreadCache(Impl::ArenaThreadCache& cache)
+{
+    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+
+    ReleaseRegion(cache);
+    ReleaseSizeClasses(cache);
+
+    auto it = std::find_if(mThreadCaches.begin(), mThreadCaches.end(), [&cache](const Impl::ArenaThreadCache& c) {
+        return &c == &cache;
+    });
+    if (it != mThreadCaches.end())
     {
-        arena = &mArenas.back();
-        if (arena->sizeLeft < size)
+        mThreadCaches.erase(it);
+    }
+}
+
+void ArenaAllocator::ReuseIfUnused(Arena& arena)
+{
+    // reference count can go up only under allocator's mutex, so unused chunk stays unused
+    // until we allocate from it
+    if (arena.referenceCount.load() == 0)
+    {
+        // mark arena as free to use again
+        arena.sizeLeft = arena.size;
+    }
+}
+
+void ArenaAllocator::ResetSizeClasses(Impl::ArenaThreadCache& cache)
+{
+    cache.sizeClasses.fill(Impl::ArenaSizeClassCache());
+    cache.sizeClassGeneration = mGeneration.load();
+}
+
+void ArenaAllocator::ReleaseSizeClasses(Impl::ArenaThreadCache& cache)
+{
+    // blocks from before FreeChunks() are already gone
+    if (cache.sizeClassGeneration == mGeneration.load())
+    {
+        for (size_t i = 0; i < Impl::ARENA_SIZE_CLASS_COUNT; ++i)
         {
-            mArenaSize *= 2; // double size
-            mArenaSize = EnsureArenaFitsSize(mArenaSize, size);
-            arena = AddChunk();
-            if (arena == nullptr)
+            Impl::ArenaSizeClassCache& c = cache.sizeClasses[i];
+            const size_t blockSize = GetSizeClassBlockSize(i);
+
+            // never used part of the page would be lost otherwise
+            for (; static_cast<size_t>(c.runEnd - c.runCurrent) >= blockSize; c.runCurrent += blockSize)
             {
-                return nullptr;
+                PushFreeBlock(c.freeList, c.runCurrent);
             }
+
+            MoveFreeBlocks(c.freeList, mSharedFreeLists[i], c.freeList.count);
         }
     }
 
-    void* ptr = arena->ptr + (arena->size - arena->sizeLeft);
-    arena->sizeLeft -= size;
-    ++arena->referenceCount;
-    return ptr;
+    ResetSizeClasses(cache);
 }
 
-void ArenaAllocator::Free(void* ptr)
+void* ArenaAllocator::RefillSizeClass(Impl::ArenaThreadCache& cache, size_t sizeClass)
 {
-    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+    Impl::ArenaSizeClassCache& c = cache.sizeClasses[sizeClass];
 
-    Arena* arena = FindArenaByPointer(ptr);
-    LKCOMMON_ASSERT(arena != nullptr, "Invalid pointer provided to free");
+    // blocks freed by other threads are reused first
+    MoveFreeBlocks(mSharedFreeLists[sizeClass], c.freeList, SIZE_CLASS_BATCH);
+    uint8_t* block = PopFreeBlock(c.freeList);
+    if (block != nullptr)
+    {
+        return ReuseFreeBlock(block);
+    }
+
+    // start a new page dedicated to the size class, which is never given back to its chunk
+    Arena* arena = ReserveChunkSpace(mPageSize, mPageSize);
+    if (arena == nullptr)
+    {
+        return nullptr;
+    }
+
+    uint8_t* top = GetChunkTop(*arena);
+    uint8_t* run = top + GetPadding(top, mPageSize);
+    arena->sizeLeft -= static_cast<size_t>(run - top) + mPageSize;
+    arena->referenceCount.fetch_add(1);
+    gChunkPageMap.SetSizeClass(run, mPageSize, static_cast<uint8_t>(sizeClass + 1));
+
+    c.runCurrent = run + GetSizeClassBlockSize(sizeClass);
+    c.runEnd = run + mPageSize;
+    return run;
+}
 
+void* ArenaAllocator::AllocateFromSizeClass(size_t sizeClass)
+{
+    Impl::ArenaThreadCache* cache = GetThreadCache();
+    if (cache->sizeClassGeneration != mGeneration.load(std::memory_order_acquire))
+    {
+        ResetSizeClasses(*cache);
+    }
+
+    Impl::ArenaSizeClassCache& c = cache->sizeClasses[sizeClass];
+    uint8_t* block = PopFreeBlock(c.freeList);
+    if (block != nullptr)
+    {
+        return ReuseFreeBlock(block);
+    }
+
+    const size_t blockSize = GetSizeClassBlockSize(sizeClass);
+    if (static_cast<size_t>(c.runEnd - c.runCurrent) >= blockSize)
+    {
+        block = c.runCurrent;
+        c.runCurrent += blockSize;
+        return block;
+    }
+
+    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+    return RefillSizeClass(*cache, sizeClass);
+}
+
+void ArenaAllocator::FreeToSizeClass(void* ptr, size_t sizeClass)
+{
     uint32_t* u32ptr = reinterpret_cast<uint32_t*>(ptr);
     LKCOMMON_ASSERT(*u32ptr != DEAD_AREA_MAGIC, "Attempted double-free");
     *u32ptr = DEAD_AREA_MAGIC;
 
-    --arena->referenceCount;
-    if (arena->referenceCount == 0)
+    Impl::ArenaThreadCache* cache = GetThreadCache();
+    if (cache->sizeClassGeneration != mGeneration.load(std::memory_order_acquire))
     {
-        // mark arena as free to use again
-        arena->sizeLeft = arena->size;
+        ResetSizeClasses(*cache);
+    }
+
+    Impl::ArenaSizeClassCache& c = cache->sizeClasses[sizeClass];
+    PushFreeBlock(c.freeList, reinterpret_cast<uint8_t*>(ptr));
+
+    // thread which only frees blocks allocated by others would collect them forever
+    if (c.freeList.count > SIZE_CLASS_FREE_LIST_LIMIT)
+    {
+        std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+        MoveFreeBlocks(c.freeList, mSharedFreeLists[sizeClass], SIZE_CLASS_BATCH);
     }
 }
 
+void* ArenaAllocator::Allocate(size_t size)
+{
+    return Allocate(size, GetNaturalAlignment(size, DEFAULT_ALIGNMENT));
+}
+
+void* ArenaAllocator::Allocate(size_t size, size_t alignment)
+{
+    LKCOMMON_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+
+    size = std::max(size, sizeof(uint32_t)); // to ensure we'll be able to fit magic
+
+    if (mMode == ArenaAllocatorMode::SMALL_OBJECTS && alignment <= MAX_SIZE_CLASS_ALLOCATION)
+    {
+        // blocks of a class are laid out from start of a page, so multiples of alignment stay aligned
+        const size_t granularity = std::max(alignment, Impl::ARENA_SIZE_CLASS_GRANULARITY);
+        const size_t blockSize = (size + granularity - 1) & ~(granularity - 1);
+        if (blockSize <= MAX_SIZE_CLASS_ALLOCATION)
+        {
+            return AllocateFromSizeClass(blockSize / Impl::ARENA_SIZE_CLASS_GRANULARITY - 1);
+        }
+    }
+
+    if (size > mMaxThreadCacheAllocationSize || alignment > mMaxThreadCacheAllocationSize)
+    {
+        std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+        return AllocateFromChunk(size, alignment);
+    }
+
+    Impl::ArenaThreadCache* cache = GetThreadCache();
+    const size_t padding = GetPadding(cache->current, alignment);
+    if (cache->generation == mGeneration.load(std::memory_order_acquire) &&
+        static_cast<size_t>(cache->end - cache->current) >= padding + size)
+    {
+        uint8_t* ptr = cache->current + padding;
+        cache->lastAllocationStart = cache->current;
+        cache->lastAllocation = ptr;
+        cache->current = ptr + size;
+        cache->allocationCount++;
+        return ptr;
+    }
+
+    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+    return AllocateFromNewRegion(*cache, size, alignment);
+}
+
+void ArenaAllocator::Free(void* ptr)
+{
+    if (mMode == ArenaAllocatorMode::SMALL_OBJECTS)
+    {
+        const uint8_t sizeClass = gChunkPageMap.GetSizeClass(ptr);
+        if (sizeClass != 0)
+        {
+            FreeToSizeClass(ptr, sizeClass - 1);
+            return;
+        }
+    }
+
+    uint32_t* u32ptr = reinterpret_cast<uint32_t*>(ptr);
+
+    // most recent allocation from calling thread's region goes straight back to the region
+    Impl::ArenaThreadCache* cache = Impl::ArenaThreadCacheRegistry::FindThreadCache(mID);
+    if (cache != nullptr && cache->lastAllocation == ptr &&
+        cache->generation == mGeneration.load(std::memory_order_acquire))
+    {
+        LKCOMMON_ASSERT(*u32ptr != DEAD_AREA_MAGIC, "Attempted double-free");
+        *u32ptr = DEAD_AREA_MAGIC;
+
+        cache->current = cache->lastAllocationStart;
+        cache->lastAllocation = nullptr;
+        cache->allocationCount--;
+        return;
+    }
+
+    Arena* arena = FindArenaByPointer(ptr);
+    LKCOMMON_ASSERT(arena != nullptr, "Invalid pointer provided to free");
+
+    LKCOMMON_ASSERT(*u32ptr != DEAD_AREA_MAGIC, "Attempted double-free");
+    *u32ptr = DEAD_AREA_MAGIC;
+
+    // space of unused chunk is reclaimed when allocator reaches for it under the mutex, so
+    // freeing does not need to lock
+    arena->referenceCount.fetch_sub(1);
+}
+
 void ArenaAllocator::FreeChunks()
 {
     std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
@@ -132,15 +902,45 @@ void ArenaAllocator::FreeChunks()
     {
         for (auto& c: mArenas)
         {
-            System::Memory::AlignedFree(c.ptr);
-            c.ptr = nullptr;
+            FreeChunk(c);
         }
 
         mArenas.clear();
     }
+
+    // burst which made chunks grow is over
+    mArenaSize = GetInitialChunkSize();
+    mSharedFreeLists.fill(Impl::ArenaFreeList());
+
+    // thread caches will drop their regions on next use
+    mGeneration.fetch_add(1);
 }
 
 void ArenaAllocator::ClearUnusedChunks()
+{
+    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+
+    Impl::ArenaThreadCache* cache = Impl::ArenaThreadCacheRegistry::FindThreadCache(mID);
+    if (cache != nullptr)
+    {
+        ReleaseRegion(*cache);
+    }
+
+    if (mArenas.empty())
+        return;
+
+    Arena& active = mArenas.back();
+    ReuseIfUnused(active);
+    if (mChunkSource != ArenaChunkSource::HEAP && active.referenceCount.load() == 0)
+    {
+        // nothing can start using the chunk while we hold the mutex
+        System::Memory::DiscardMemory(active.ptr, active.size);
+    }
+
+    FreeUnusedChunks();
+}
+
+void ArenaAllocator::FreeUnusedChunks()
 {
     if (mArenas.size() <= 1)
         return;
@@ -150,12 +950,51 @@ void ArenaAllocator::ClearUnusedChunks()
 
     while(it != lastIt)
     {
-        if (it->referenceCount == 0)
+        if (it->referenceCount.load() == 0)
+        {
+            FreeChunk(*it);
             it = mArenas.erase(it);
+        }
         else
             ++it;
     }
 }
 
+void ArenaAllocator::SetGrowthPolicy(const ArenaGrowthPolicy& policy)
+{
+    LKCOMMON_ASSERT(policy.growthFactor >= 1.0f, "Chunk growth factor must not be lower than 1");
+
+    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+
+    mGrowthPolicy = policy;
+    if (mArenas.empty())
+    {
+        mArenaSize = GetInitialChunkSize();
+    }
+}
+
+ArenaGrowthPolicy ArenaAllocator::GetGrowthPolicy()
+{
+    std::lock_guard<std::mutex> allocatorGuard(mAllocatorMutex);
+    return mGrowthPolicy;
+}
+
+size_t ArenaAllocator::GetFreeChunkSpace() const
+{
+    if (mArenas.empty())
+        return mArenaSize;
+
+    const Arena& active = mArenas.back();
+    size_t freeSpace = (active.referenceCount.load() == 0) ? active.size : active.sizeLeft;
+
+    const Impl::ArenaThreadCache* cache = Impl::ArenaThreadCacheRegistry::FindThreadCache(mID);
+    if (cache != nullptr && cache->arena == &mArenas.back() && cache->generation == mGeneration.load())
+    {
+        freeSpace += static_cast<size_t>(cache->end - cache->current);
+    }
+
+    return freeSpace;
+}
+
 } // namespace Utils
 } // namespace lkCommon
@@ -0,0 +1,120 @@
+#include "lkCommon/Utils/FrameAllocator.hpp"
+#include "lkCommon/Utils/Logger.hpp"
+
+#include <algorithm>
+
+
+namespace lkCommon {
+namespace Utils {
+
+const size_t FrameAllocator::DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+
+FrameAllocator::Scope::Scope(FrameAllocator& allocator)
+    : mAllocator(allocator)
+    , mMarker(allocator.GetMarker())
+{
+}
+
+FrameAllocator::Scope::~Scope()
+{
+    mAllocator.RewindTo(mMarker);
+}
+
+
+FrameAllocator::FrameAllocator(ArenaAllocator& allocator, size_t blockSize)
+    : mAllocator(allocator)
+    , mBlockSize(blockSize)
+    , mBlocks()
+    , mCurrentBlock(0)
+    , mCurrent(nullptr)
+    , mEnd(nullptr)
+{
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    ReleaseBlocks();
+}
+
+void* FrameAllocator::AllocateFromNextBlock(size_t size, size_t alignment)
+{
+    LKCOMMON_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+
+    // blocks are aligned only to ArenaAllocator's default alignment
+    const size_t requiredSize = size + ((alignment > ArenaAllocator::DEFAULT_ALIGNMENT) ? alignment : 0);
+    const size_t next = mBlocks.empty() ? 0 : mCurrentBlock + 1;
+
+    if (next == mBlocks.size() || mBlocks[next].size < requiredSize)
+    {
+        // block too small for this allocation stays in place for the following ones
+        Block block;
+        block.size = std::max(mBlockSize, requiredSize);
+        block.ptr = reinterpret_cast<uint8_t*>(mAllocator.Allocate(block.size, ArenaAllocator::DEFAULT_ALIGNMENT));
+        if (block.ptr == nullptr)
+        {
+            LOGE("Failed to acquire block of size " << block.size << " for frame allocator");
+            return nullptr;
+        }
+
+        // block's start might never be written to, while ArenaAllocator checks it for magic
+        // left by freeing to detect double-frees - recycled memory could still contain one
+        *reinterpret_cast<uint32_t*>(block.ptr) = 0;
+
+        mBlocks.insert(mBlocks.begin() + next, block);
+    }
+
+    mCurrentBlock = next;
+    mCurrent = mBlocks[next].ptr;
+    mEnd = mBlocks[next].ptr + mBlocks[next].size;
+    return Allocate(size, alignment);
+}
+
+FrameAllocator::Marker FrameAllocator::GetMarker() const
+{
+    Marker marker;
+    marker.block = mCurrentBlock;
+    marker.offset = mBlocks.empty() ? 0 : static_cast<size_t>(mCurrent - mBlocks[mCurrentBlock].ptr);
+    return marker;
+}
+
+void FrameAllocator::RewindTo(const Marker& marker)
+{
+    if (mBlocks.empty())
+    {
+        return;
+    }
+
+    LKCOMMON_ASSERT(marker.block < mCurrentBlock ||
+                    (marker.block == mCurrentBlock && mBlocks[marker.block].ptr + marker.offset <= mCurrent),
+                    "Attempted to rewind frame allocator forward");
+
+    const Block& block = mBlocks[marker.block];
+    mCurrentBlock = marker.block;
+    mCurrent = block.ptr + marker.offset;
+    mEnd = block.ptr + block.size;
+}
+
+void FrameAllocator::Reset()
+{
+    Marker start;
+    start.block = 0;
+    start.offset = 0;
+    RewindTo(start);
+}
+
+void FrameAllocator::ReleaseBlocks()
+{
+    for (const Block& b: mBlocks)
+    {
+        mAllocator.Free(b.ptr);
+    }
+
+    mBlocks.clear();
+    mCurrentBlock = 0;
+    mCurrent = nullptr;
+    mEnd = nullptr;
+}
+
+} // namespace Utils
+} // namespace lkCommon
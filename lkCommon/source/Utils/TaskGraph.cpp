@@ -0,0 +1,181 @@
+/**
+ * @file
+ * @author LKostyra (costyrra.xl@gmail.com)
+ * @brief  Task dependency graph executed on ThreadPool
+ */
+
+#include "lkCommon/Utils/TaskGraph.hpp"
+
+#include <algorithm>
+
+
+namespace lkCommon {
+namespace Utils {
+
+TaskGraph::Node::Node(TaskCallback&& cb)
+    : callback(std::move(cb))
+    , successors()
+    , dependencyCount(0)
+    , pendingDependencies(0)
+{
+}
+
+
+TaskGraph::TaskGraph()
+    : mNodes()
+    , mPool(nullptr)
+    , mTaskGroup()
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+    Wait();
+}
+
+bool TaskGraph::IsAcyclic() const
+{
+    // Kahn's algorithm - if we cannot visit every node, there is a cycle
+    std::vector<uint32_t> dependencies(mNodes.size());
+    std::vector<NodeID> ready;
+    for (NodeID i = 0; i < mNodes.size(); ++i)
+    {
+        dependencies[i] = mNodes[i].dependencyCount;
+        if (dependencies[i] == 0)
+            ready.push_back(i);
+    }
+
+    size_t visited = 0;
+    while (!ready.empty())
+    {
+        NodeID id = ready.back();
+        ready.pop_back();
+        visited++;
+
+        for (NodeID s: mNodes[id].successors)
+        {
+            if (--dependencies[s] == 0)
+                ready.push_back(s);
+        }
+    }
+
+    return visited == mNodes.size();
+}
+
+void TaskGraph::ExecuteNode(NodeID id, ThreadPayload& payload)
+{
+    while (true)
+    {
+        Node& node = mNodes[id];
+        node.callback(payload);
+
+        // continue with first successor made runnable, submit the rest
+        NodeID next = mNodes.size();
+        for (NodeID s: node.successors)
+        {
+            if (mNodes[s].pendingDependencies.fetch_sub(1) != 1)
+                continue;
+
+            if (next == mNodes.size())
+            {
+                next = s;
+            }
+            else
+            {
+                mPool->AddTask([this, s](ThreadPayload& p) {
+                    ExecuteNode(s, p);
+                }, mTaskGroup);
+            }
+        }
+
+        if (next == mNodes.size())
+            break;
+
+        id = next;
+    }
+}
+
+TaskGraph::NodeID TaskGraph::AddTask(TaskCallback&& callback, const std::vector<NodeID>& dependencies)
+{
+    LKCOMMON_ASSERT(mTaskGroup.IsDone(), "Cannot modify TaskGraph while it is running");
+
+    mNodes.emplace_back(std::move(callback));
+    NodeID id = mNodes.size() - 1;
+
+    for (NodeID d: dependencies)
+    {
+        if (!AddDependency(id, d))
+        {
+            LOGW("Skipping invalid dependency " << d << " of task " << id);
+        }
+    }
+
+    return id;
+}
+
+bool TaskGraph::AddDependency(NodeID id, NodeID dependency)
+{
+    LKCOMMON_ASSERT(mTaskGroup.IsDone(), "Cannot modify TaskGraph while it is running");
+
+    if (id >= mNodes.size() || dependency >= mNodes.size() || id == dependency)
+    {
+        return false;
+    }
+
+    std::vector<NodeID>& successors = mNodes[dependency].successors;
+    if (std::find(successors.begin(), successors.end(), id) != successors.end())
+    {
+        // already depends on it
+        return true;
+    }
+
+    successors.push_back(id);
+    mNodes[id].dependencyCount++;
+    return true;
+}
+
+bool TaskGraph::Run(ThreadPool& pool)
+{
+    LKCOMMON_ASSERT(mTaskGroup.IsDone(), "TaskGraph is already running");
+
+    if (!IsAcyclic())
+    {
+        LOGE("TaskGraph contains a dependency cycle, cannot run it");
+        return false;
+    }
+
+    mPool = &pool;
+
+    std::vector<TaskCallback> rootTasks;
+    for (NodeID i = 0; i < mNodes.size(); ++i)
+    {
+        mNodes[i].pendingDependencies.store(mNodes[i].dependencyCount);
+        if (mNodes[i].dependencyCount == 0)
+        {
+            rootTasks.emplace_back([this, i](ThreadPayload& payload) {
+                ExecuteNode(i, payload);
+            });
+        }
+    }
+
+    mPool->AddTasks(std::move(rootTasks), mTaskGroup);
+    return true;
+}
+
+void TaskGraph::Wait()
+{
+    if (mPool != nullptr)
+    {
+        mPool->WaitForTasks(mTaskGroup);
+    }
+}
+
+void TaskGraph::Clear()
+{
+    LKCOMMON_ASSERT(mTaskGroup.IsDone(), "Cannot modify TaskGraph while it is running");
+
+    mNodes.clear();
+}
+
+} // namespace Utils
+} // namespace lkCommon
@@ -5,243 +5,1411 @@
  */
 
 #include "lkCommon/Utils/ThreadPool.hpp"
+#include "lkCommon/System/Affinity.hpp"
+
 #include <limits>
+#include <memory>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <emmintrin.h>
+
+
+namespace {
+
+// Pool and worker executing current thread, nullptr if thread is not a worker
+thread_local const lkCommon::Utils::ThreadPool* tCurrentPool = nullptr;
+thread_local lkCommon::Utils::Thread* tCurrentThread = nullptr;
+
+// Monotonic timestamp in nanoseconds used by Pool's statistics, never zero
+uint64_t GetTimestamp()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count()) + 1;
+}
+
+void UpdateMax(std::atomic<uint64_t>& max, uint64_t value)
+{
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current &&
+           !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Picks logical processors for worker threads according to affinity policy
+std::vector<lkCommon::System::Info::LogicalCPU> SelectWorkerCPUs(size_t threadCount,
+                                                                 lkCommon::Utils::WorkerAffinity affinity)
+{
+    using lkCommon::System::Info::LogicalCPU;
+
+    std::vector<LogicalCPU> topology = lkCommon::System::Info::GetCPUTopology();
+    if (topology.empty())
+    {
+        return topology;
+    }
+
+    // number SMT siblings of each physical core - 0 for first logical
+    // processor of a core, 1 for the second one and so on
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> coreSiblings;
+    std::vector<std::pair<uint32_t, LogicalCPU>> ranked;
+    for (const LogicalCPU& cpu: topology)
+    {
+        uint32_t sibling = coreSiblings[std::make_pair(cpu.package, cpu.core)]++;
+        ranked.emplace_back(sibling, cpu);
+    }
+
+    std::stable_sort(ranked.begin(), ranked.end(),
+        [](const std::pair<uint32_t, LogicalCPU>& a, const std::pair<uint32_t, LogicalCPU>& b) {
+            return a.first < b.first;
+        }
+    );
+
+    std::vector<LogicalCPU> selected;
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        selected.push_back(ranked[i % ranked.size()].second);
+    }
+
+    if (affinity == lkCommon::Utils::WorkerAffinity::NUMA_NODES)
+    {
+        std::stable_sort(selected.begin(), selected.end(), [](const LogicalCPU& a, const LogicalCPU& b) {
+            return a.numaNode < b.numaNode;
+        });
+    }
+
+    return selected;
+}
+
+} // namespace
+
+
+namespace lkCommon {
+namespace Utils {
+
+
+TaskGroup::TaskGroup()
+    : mPendingTasks(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    LKCOMMON_ASSERT(mPendingTasks.load() == 0, "Task group destroyed while its tasks are still pending");
+}
+
+void TaskGroup::AddPendingTasks(size_t count)
+{
+    mPendingTasks.fetch_add(count);
+}
+
+bool TaskGroup::FinishTask()
+{
+    // group must not be touched after this - waiting thread might see the
+    // counter drop to zero, leave and destroy the group right away
+    return (mPendingTasks.fetch_sub(1) == 1);
+}
+
+
+const size_t Task::INLINE_STORAGE_SIZE;
+
+Task::Task()
+    : mStorage()
+    , mInvoke(nullptr)
+    , mRelocate(nullptr)
+    , group(nullptr)
+    , submitTime(0)
+{
+}
+
+Task::~Task()
+{
+    Reset();
+}
+
+Task::Task(Task&& other) noexcept
+    : mStorage()
+    , mInvoke(nullptr)
+    , mRelocate(nullptr)
+    , group(nullptr)
+    , submitTime(0)
+{
+    MoveFrom(other);
+}
+
+Task& Task::operator=(Task&& other) noexcept
+{
+    if (this != &other)
+    {
+        Reset();
+        MoveFrom(other);
+    }
+
+    return *this;
+}
+
+void Task::MoveFrom(Task& other)
+{
+    if (other.mInvoke != nullptr)
+    {
+        other.mRelocate(&mStorage, &other.mStorage);
+    }
+
+    mInvoke = other.mInvoke;
+    mRelocate = other.mRelocate;
+    group = other.group;
+    submitTime = other.submitTime;
+
+    other.mInvoke = nullptr;
+    other.mRelocate = nullptr;
+    other.group = nullptr;
+    other.submitTime = 0;
+}
+
+void Task::Reset()
+{
+    if (mInvoke != nullptr)
+    {
+        mRelocate(nullptr, &mStorage);
+        mInvoke = nullptr;
+        mRelocate = nullptr;
+    }
+}
+
+
+TaskQueue::TaskQueue(size_t capacity)
+    : mTasks()
+    , mHead(0)
+    , mSize(0)
+{
+    size_t powerOfTwo = 1;
+    while (powerOfTwo < capacity)
+    {
+        powerOfTwo <<= 1;
+    }
+
+    mTasks.resize(powerOfTwo);
+}
+
+void TaskQueue::Grow()
+{
+    std::vector<Task> tasks(mTasks.size() * 2);
+    for (size_t i = 0; i < mSize; ++i)
+    {
+        tasks[i] = std::move(mTasks[(mHead + i) & (mTasks.size() - 1)]);
+    }
+
+    mTasks.swap(tasks);
+    mHead = 0;
+}
+
+void TaskQueue::PushBack(Task&& task)
+{
+    if (mSize == mTasks.size())
+    {
+        Grow();
+    }
+
+    mTasks[(mHead + mSize) & (mTasks.size() - 1)] = std::move(task);
+    mSize++;
+}
+
+bool TaskQueue::PopFront(Task& task)
+{
+    if (mSize == 0)
+    {
+        return false;
+    }
+
+    task = std::move(mTasks[mHead]);
+    mHead = (mHead + 1) & (mTasks.size() - 1);
+    mSize--;
+    return true;
+}
+
+bool TaskQueue::PopBack(Task& task)
+{
+    if (mSize == 0)
+    {
+        return false;
+    }
+
+    mSize--;
+    task = std::move(mTasks[(mHead + mSize) & (mTasks.size() - 1)]);
+    return true;
+}
+
+
+const size_t DurationHistogram::BUCKET_COUNT;
+
+DurationHistogram::DurationHistogram()
+    : buckets()
+    , count(0)
+    , totalNanoseconds(0)
+    , maxNanoseconds(0)
+{
+}
+
+size_t DurationHistogram::GetBucket(uint64_t nanoseconds)
+{
+    uint64_t microseconds = nanoseconds / 1000;
+    size_t bucket = 0;
+    while (microseconds > 0 && bucket < BUCKET_COUNT - 1)
+    {
+        microseconds >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+uint64_t DurationHistogram::GetBucketUpperBound(size_t bucket)
+{
+    if (bucket >= BUCKET_COUNT - 1)
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    return static_cast<uint64_t>(1) << bucket;
+}
+
+uint64_t DurationHistogram::GetAverageNanoseconds() const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    return totalNanoseconds / count;
+}
+
+uint64_t DurationHistogram::GetPercentile(double percentile) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const double threshold = (percentile / 100.0) * static_cast<double>(count);
+    uint64_t accumulated = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        accumulated += buckets[i];
+        if (static_cast<double>(accumulated) >= threshold && accumulated > 0)
+        {
+            return GetBucketUpperBound(i);
+        }
+    }
+
+    return GetBucketUpperBound(BUCKET_COUNT - 1);
+}
+
+
+WorkerStatistics::WorkerStatistics()
+    : tasksExecuted(0)
+    , busyNanoseconds(0)
+    , idleNanoseconds(0)
+{
+}
+
+double WorkerStatistics::GetUtilization() const
+{
+    const uint64_t total = busyNanoseconds + idleNanoseconds;
+    if (total == 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(busyNanoseconds) / static_cast<double>(total);
+}
+
+
+ThreadPoolStatistics::ThreadPoolStatistics()
+    : tasksSubmitted(0)
+    , tasksCompleted(0)
+    , queueHighWaterMark(0)
+    , queueLatency()
+    , runTime()
+    , workers()
+    , externalThreads()
+{
+}
+
+
+namespace Impl {
+
+ThreadStatistics::ThreadStatistics()
+{
+    Reset(0);
+}
+
+void ThreadStatistics::Reset(uint64_t now)
+{
+    tasksExecuted.store(0, std::memory_order_relaxed);
+    busyNanoseconds.store(0, std::memory_order_relaxed);
+    idleNanoseconds.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < DurationHistogram::BUCKET_COUNT; ++i)
+    {
+        queueLatency[i].store(0, std::memory_order_relaxed);
+        runTime[i].store(0, std::memory_order_relaxed);
+    }
+    queueLatencyTotal.store(0, std::memory_order_relaxed);
+    queueLatencyMax.store(0, std::memory_order_relaxed);
+    runTimeTotal.store(0, std::memory_order_relaxed);
+    runTimeMax.store(0, std::memory_order_relaxed);
+
+    // idle period in progress is counted from now on
+    if (now == 0)
+    {
+        idleSince.store(0, std::memory_order_relaxed);
+    }
+    else
+    {
+        uint64_t since = idleSince.load(std::memory_order_relaxed);
+        if (since != 0)
+        {
+            idleSince.compare_exchange_strong(since, now, std::memory_order_relaxed);
+        }
+    }
+}
+
+void ThreadStatistics::RecordTask(uint64_t submitTime, uint64_t startTime, uint64_t endTime)
+{
+    if (submitTime != 0 && startTime > submitTime)
+    {
+        const uint64_t latency = startTime - submitTime;
+        queueLatency[DurationHistogram::GetBucket(latency)].fetch_add(1, std::memory_order_relaxed);
+        queueLatencyTotal.fetch_add(latency, std::memory_order_relaxed);
+        UpdateMax(queueLatencyMax, latency);
+    }
+
+    const uint64_t duration = endTime - startTime;
+    runTime[DurationHistogram::GetBucket(duration)].fetch_add(1, std::memory_order_relaxed);
+    runTimeTotal.fetch_add(duration, std::memory_order_relaxed);
+    UpdateMax(runTimeMax, duration);
+
+    busyNanoseconds.fetch_add(duration, std::memory_order_relaxed);
+    tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ThreadStatistics::BeginIdle(uint64_t now)
+{
+    if (idleSince.load(std::memory_order_relaxed) == 0)
+    {
+        idleSince.store(now, std::memory_order_relaxed);
+    }
+}
+
+void ThreadStatistics::EndIdle(uint64_t now)
+{
+    const uint64_t since = idleSince.exchange(0, std::memory_order_relaxed);
+    if (since != 0 && now > since)
+    {
+        idleNanoseconds.fetch_add(now - since, std::memory_order_relaxed);
+    }
+}
 
+void ThreadStatistics::CancelIdle()
+{
+    idleSince.store(0, std::memory_order_relaxed);
+}
+
+void ThreadStatistics::Collect(ThreadPoolStatistics& stats, WorkerStatistics& worker, uint64_t now) const
+{
+    worker.tasksExecuted = tasksExecuted.load(std::memory_order_relaxed);
+    worker.busyNanoseconds = busyNanoseconds.load(std::memory_order_relaxed);
+    worker.idleNanoseconds = idleNanoseconds.load(std::memory_order_relaxed);
+
+    const uint64_t since = idleSince.load(std::memory_order_relaxed);
+    if (since != 0 && now > since)
+    {
+        worker.idleNanoseconds += now - since;
+    }
+
+    stats.tasksCompleted += worker.tasksExecuted;
+
+    uint64_t latencyCount = 0;
+    for (size_t i = 0; i < DurationHistogram::BUCKET_COUNT; ++i)
+    {
+        const uint64_t latency = queueLatency[i].load(std::memory_order_relaxed);
+        const uint64_t run = runTime[i].load(std::memory_order_relaxed);
+        stats.queueLatency.buckets[i] += latency;
+        stats.runTime.buckets[i] += run;
+        stats.runTime.count += run;
+        latencyCount += latency;
+    }
+
+    stats.queueLatency.count += latencyCount;
+    stats.queueLatency.totalNanoseconds += queueLatencyTotal.load(std::memory_order_relaxed);
+    stats.queueLatency.maxNanoseconds = std::max(stats.queueLatency.maxNanoseconds,
+                                                 queueLatencyMax.load(std::memory_order_relaxed));
+    stats.runTime.totalNanoseconds += runTimeTotal.load(std::memory_order_relaxed);
+    stats.runTime.maxNanoseconds = std::max(stats.runTime.maxNanoseconds,
+                                            runTimeMax.load(std::memory_order_relaxed));
+}
+
+} // namespace Impl
+
+
+static_assert(TASK_PRIORITY_COUNT == 3, "Thread constructor must create one task queue per priority");
+
+const size_t Thread::DEFAULT_TASK_QUEUE_CAPACITY;
+const uint32_t Thread::NO_CPU;
+
+Thread::Thread()
+    : thread()
+    , payload()
+    , tasks{{
+        TaskQueue(DEFAULT_TASK_QUEUE_CAPACITY),
+        TaskQueue(DEFAULT_TASK_QUEUE_CAPACITY),
+        TaskQueue(DEFAULT_TASK_QUEUE_CAPACITY),
+      }}
+    , tasksMutex()
+    , queuedTasks()
+    , skippedPicks()
+    , cpu(NO_CPU)
+    , numaNode(0)
+    , retired(false)
+{
+    for (auto& queued: queuedTasks)
+    {
+        queued.store(0);
+    }
+}
+
+Thread::~Thread()
+{
+}
+
+
+const uint32_t WorkerIdlePolicy::DEFAULT_SPIN_COUNT;
+const uint32_t WorkerIdlePolicy::DEFAULT_YIELD_COUNT;
+
+const uint32_t ThreadPool::PRIORITY_AGING_LIMIT;
+const size_t ThreadPool::MAX_WORKER_THREADS;
+const size_t ThreadPool::SUBMISSION_QUEUE_SIZE;
+
+ThreadPool::ThreadPool()
+    : ThreadPool(0, WorkerAffinity::NONE)
+{
+}
+
+ThreadPool::ThreadPool(size_t threads)
+    : ThreadPool(threads, WorkerAffinity::NONE)
+{
+}
+
+ThreadPool::ThreadPool(size_t threads, WorkerAffinity affinity)
+    : mExitFlag(false)
+    , mAffinity(affinity)
+    , mStartedWorkerThreads(0)
+    , mWorkerThreads(MAX_WORKER_THREADS)
+    , mCreatedWorkerThreads(0)
+    , mWorkerThreadCount(0)
+    , mResizeMutex()
+    , mSubmittedTasks()
+    , mQueuedTasks(0)
+    , mQueuedTasksByPriority()
+    , mActiveTasks(0)
+    , mSuspendedTasks(0)
+    , mSleepingWorkerThreads(0)
+    , mWaitingThreads(0)
+    , mNextWorkerThread(0)
+    , mIdleSpinCount(WorkerIdlePolicy::DEFAULT_SPIN_COUNT)
+    , mIdleYieldCount(WorkerIdlePolicy::DEFAULT_YIELD_COUNT)
+    , mStatisticsEnabled(false)
+    , mTasksSubmitted(0)
+    , mQueueHighWaterMark(0)
+    , mExternalThreadStatistics()
+    , mPoolStateMutex()
+    , mStartupStateCV()
+    , mTaskAvailableCV()
+    , mTasksDoneCV()
+{
+    for (auto& queued: mQueuedTasksByPriority)
+    {
+        queued.store(0);
+    }
+
+    SetWorkerThreadCount(threads);
+}
+
+ThreadPool::~ThreadPool()
+{
+    WaitForTasks();
+
+    {
+        LockGuard lock(mPoolStateMutex);
+        mExitFlag = true; // enables flag, which will purge the thread pool
+    }
+    mTaskAvailableCV.notify_all();
+
+    for (auto& t: mWorkerThreads)
+    {
+        if (t && t->thread.joinable())
+        {
+            t->thread.join();
+        }
+    }
+}
+
+void ThreadPool::PlaceThreads(size_t first, size_t last)
+{
+    if (mAffinity == WorkerAffinity::NONE)
+    {
+        return;
+    }
+
+    // select processors for the whole Pool and skip ones already taken by
+    // existing workers, so workers added later fill the gaps
+    std::vector<System::Info::LogicalCPU> cpus = SelectWorkerCPUs(last, mAffinity);
+    for (size_t i = 0; i < first; ++i)
+    {
+        const uint32_t taken = mWorkerThreads[i]->cpu;
+        auto it = std::find_if(cpus.begin(), cpus.end(), [taken](const System::Info::LogicalCPU& cpu) {
+            return cpu.id == taken;
+        });
+        if (it != cpus.end())
+        {
+            cpus.erase(it);
+        }
+    }
+
+    for (size_t i = first; (i < last) && (i - first < cpus.size()); ++i)
+    {
+        mWorkerThreads[i]->cpu = cpus[i - first].id;
+        mWorkerThreads[i]->numaNode = cpus[i - first].numaNode;
+    }
+}
+
+void ThreadPool::SpawnThreads(size_t first, size_t last)
+{
+    // threads are created only once, placement of a thread which comes back
+    // after being retired stays the same
+    const size_t created = mCreatedWorkerThreads.load();
+    for (size_t i = created; i < last; ++i)
+    {
+        mWorkerThreads[i].reset(new Thread());
+        mWorkerThreads[i]->payload.tid = static_cast<uint16_t>(i);
+    }
+
+    if (last > created)
+    {
+        PlaceThreads(created, last);
+        mCreatedWorkerThreads.store(last);
+    }
+
+    {
+        LockGuard lock(mPoolStateMutex);
+        mStartedWorkerThreads = 0;
+    }
+
+    for (size_t i = first; i < last; ++i)
+    {
+        Thread& t = *mWorkerThreads[i];
+        if (t.thread.joinable())
+        {
+            t.thread.join();
+        }
+
+        t.retired = false;
+        t.thread = std::thread(&ThreadPool::WorkerThreadFunction, this, std::ref(t));
+    }
+
+    {
+        UniqueLock lock(mPoolStateMutex);
+        mStartupStateCV.wait(lock, [this, first, last]() {
+            return (mStartedWorkerThreads == last - first);
+        });
+    }
+
+    mWorkerThreadCount.store(last);
+}
+
+void ThreadPool::RetireThreads(size_t first, size_t last)
+{
+    // new tasks from outside of the Pool stop landing on retired workers now,
+    // tasks which already did will be finished by retired workers or stolen
+    mWorkerThreadCount.store(first);
+
+    {
+        LockGuard lock(mPoolStateMutex);
+        for (size_t i = first; i < last; ++i)
+        {
+            mWorkerThreads[i]->retired = true;
+        }
+    }
+    mTaskAvailableCV.notify_all();
+
+    for (size_t i = first; i < last; ++i)
+    {
+        mWorkerThreads[i]->thread.join();
+    }
+}
+
+bool ThreadPool::SetWorkerThreadCount(size_t threads)
+{
+    if (tCurrentPool == this)
+    {
+        LOGE("Cannot change worker thread count from inside of a task");
+        return false;
+    }
+
+    if (threads == 0)
+    {
+        threads = lkCommon::System::Info::GetCPUCount();
+    }
+
+    if (threads > MAX_WORKER_THREADS)
+    {
+        LOGW("Requested " << threads << " worker threads, limiting to " << MAX_WORKER_THREADS);
+        threads = MAX_WORKER_THREADS;
+    }
+
+    LockGuard lock(mResizeMutex);
+
+    const size_t current = mWorkerThreadCount.load();
+    if (threads > current)
+    {
+        SpawnThreads(current, threads);
+    }
+    else if (threads < current)
+    {
+        RetireThreads(threads, current);
+    }
+
+    return true;
+}
+
+size_t ThreadPool::SelectWorkerThread()
+{
+    // tasks added from our own worker go to its deque to keep them close to
+    // data they were spawned from
+    if (tCurrentPool == this)
+    {
+        return tCurrentThread->payload.tid;
+    }
+
+    return mNextWorkerThread.fetch_add(1, std::memory_order_relaxed) % mWorkerThreadCount.load();
+}
+
+void ThreadPool::PushTask(Task&& task, TaskPriority priority)
+{
+    const size_t p = static_cast<size_t>(priority);
+
+    // counters are bumped before the task becomes visible, so a worker
+    // which steals it right away will never underflow them
+    if (task.group != nullptr)
+    {
+        task.group->AddPendingTasks(1);
+    }
+
+    mActiveTasks.fetch_add(1);
+    mQueuedTasksByPriority[p].fetch_add(1);
+    const size_t queuedTasks = mQueuedTasks.fetch_add(1) + 1;
+
+    if (IsStatisticsEnabled())
+    {
+        task.submitTime = GetTimestamp();
+        RecordSubmittedTasks(1, queuedTasks);
+    }
+
+    // tasks from outside of the pool skip workers' locks, unless submission
+    // queue is full - then they fall back to round-robin over deques
+    if (tCurrentPool != this && mSubmittedTasks[p].TryPush(std::move(task)))
+    {
+        return;
+    }
+
+    Thread& t = *mWorkerThreads[SelectWorkerThread()];
+    {
+        LockGuard lock(t.tasksMutex);
+        t.tasks[p].PushBack(std::move(task));
+        t.queuedTasks[p].fetch_add(1);
+    }
+}
+
+template <typename TaskGenerator>
+void ThreadPool::PushTasks(size_t count, TaskGroup* group, TaskPriority priority, TaskGenerator&& generator)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    const size_t p = static_cast<size_t>(priority);
+
+    if (group != nullptr)
+    {
+        group->AddPendingTasks(count);
+    }
+
+    mActiveTasks.fetch_add(count);
+    mQueuedTasksByPriority[p].fetch_add(count);
+    const size_t queuedTasks = mQueuedTasks.fetch_add(count) + count;
+
+    // whole batch shares one submission timestamp
+    uint64_t submitTime = 0;
+    if (IsStatisticsEnabled())
+    {
+        submitTime = GetTimestamp();
+        RecordSubmittedTasks(count, queuedTasks);
+    }
+
+    auto generateTask = [&generator, submitTime](size_t i) {
+        Task task = generator(i);
+        task.submitTime = submitTime;
+        return task;
+    };
+
+    if (tCurrentPool == this)
+    {
+        // keep the whole batch local, other workers will steal what they need
+        LockGuard lock(tCurrentThread->tasksMutex);
+        for (size_t i = 0; i < count; ++i)
+        {
+            tCurrentThread->tasks[p].PushBack(generateTask(i));
+        }
+        tCurrentThread->queuedTasks[p].fetch_add(count);
+
+        return;
+    }
+
+    // split the batch into contiguous ranges, one per worker thread, starting
+    // from the worker round-robin counter points to
+    const size_t threadCount = mWorkerThreadCount.load();
+    const size_t firstThread = mNextWorkerThread.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        const size_t rangeStart = (count * i) / threadCount;
+        const size_t rangeEnd = (count * (i + 1)) / threadCount;
+        if (rangeStart == rangeEnd)
+        {
+            continue;
+        }
+
+        Thread& t = *mWorkerThreads[(firstThread + i) % threadCount];
+
+        LockGuard lock(t.tasksMutex);
+        for (size_t task = rangeStart; task < rangeEnd; ++task)
+        {
+            t.tasks[p].PushBack(generateTask(task));
+        }
+        t.queuedTasks[p].fetch_add(rangeEnd - rangeStart);
+    }
+}
+
+bool ThreadPool::PopTask(Thread* self, Task& task)
+{
+    // lower priority which was passed over too many times goes first
+    if (self != nullptr)
+    {
+        for (size_t p = 1; p < TASK_PRIORITY_COUNT; ++p)
+        {
+            if (self->skippedPicks[p] >= PRIORITY_AGING_LIMIT && PopTask(self, task, p))
+            {
+                return true;
+            }
+        }
+    }
 
-namespace lkCommon {
-namespace Utils {
+    for (size_t p = 0; p < TASK_PRIORITY_COUNT; ++p)
+    {
+        if (PopTask(self, task, p))
+        {
+            return true;
+        }
+    }
 
+    return false;
+}
 
-Task::Task()
-    : function()
+bool ThreadPool::PopTask(Thread* self, Task& task, size_t priority)
 {
+    if (mQueuedTasksByPriority[priority].load() == 0)
+    {
+        return false;
+    }
+
+    bool found = false;
+    if (self != nullptr && self->queuedTasks[priority].load() > 0)
+    {
+        LockGuard lock(self->tasksMutex);
+        found = self->tasks[priority].PopFront(task);
+        if (found)
+        {
+            self->queuedTasks[priority].fetch_sub(1);
+        }
+    }
+
+    if (!found)
+    {
+        found = PopSubmittedTask(task, priority);
+    }
+
+    if (!found)
+    {
+        found = StealTask(self, task, priority);
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    mQueuedTasksByPriority[priority].fetch_sub(1);
+    mQueuedTasks.fetch_sub(1);
+
+    // age lower priorities which still have tasks waiting
+    if (self != nullptr)
+    {
+        self->skippedPicks[priority] = 0;
+        for (size_t p = priority + 1; p < TASK_PRIORITY_COUNT; ++p)
+        {
+            if (mQueuedTasksByPriority[p].load() > 0)
+            {
+                self->skippedPicks[p]++;
+            }
+        }
+    }
+
+    return true;
 }
 
-Task::Task(TaskCallback&& callback)
-    : function(std::move(callback))
+bool ThreadPool::PopSubmittedTask(Task& task, size_t priority)
 {
+    // popping from an empty queue only reads shared state, no need to check
+    // its size upfront
+    return mSubmittedTasks[priority].TryPop(task);
 }
 
-
-Thread::Thread()
-    : thread()
-    , assignedTask()
-    , payload()
-    , taskReady(false)
-    , stateMutex()
-    , taskReadyCV()
+bool ThreadPool::PopOwnTask(Thread& self, Task& task)
 {
+    for (size_t p = 0; p < TASK_PRIORITY_COUNT; ++p)
+    {
+        bool found = false;
+        {
+            LockGuard lock(self.tasksMutex);
+            found = self.tasks[p].PopFront(task);
+            if (found)
+            {
+                self.queuedTasks[p].fetch_sub(1);
+            }
+        }
+
+        if (found)
+        {
+            mQueuedTasksByPriority[p].fetch_sub(1);
+            mQueuedTasks.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
 }
 
-Thread::~Thread()
+bool ThreadPool::StealTask(Thread* self, Task& task, size_t priority)
 {
-}
+    // retired workers are checked too - tasks could land on them right
+    // before they were retired
+    const size_t threadCount = mCreatedWorkerThreads.load();
 
+    if (self == nullptr)
+    {
+        // thread from outside of the pool robs workers in order
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            if (StealTask(*mWorkerThreads[i], task, priority))
+            {
+                return true;
+            }
+        }
 
-ThreadPool::ThreadPool()
-    : mDispatchThreadCV()
-    , mExitFlag(false)
-    , mDispatchThread()
-    , mAvailableWorkerThreads(0)
-    , mWorkerThreads(lkCommon::System::Info::GetCPUCount())
-    , mPoolStateMutex()
-    , mStartupStateCV()
-    , mTasksDoneCV()
-    , mTaskQueue()
-{
-    SpawnThreads();
+        return false;
+    }
+
+    // rob neighbours from the same NUMA node first, keeping ring order
+    const size_t selfID = self->payload.tid;
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+        for (size_t i = 1; i < threadCount; ++i)
+        {
+            Thread& victim = *mWorkerThreads[(selfID + i) % threadCount];
+            if ((victim.numaNode == self->numaNode) != (pass == 0))
+            {
+                continue;
+            }
+
+            if (StealTask(victim, task, priority))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
 }
 
-ThreadPool::ThreadPool(size_t threads)
-    : mDispatchThreadCV()
-    , mExitFlag(false)
-    , mDispatchThread()
-    , mAvailableWorkerThreads(0)
-    , mWorkerThreads(threads != 0 ? threads : lkCommon::System::Info::GetCPUCount())
-    , mPoolStateMutex()
-    , mStartupStateCV()
-    , mTasksDoneCV()
-    , mTaskQueue()
+bool ThreadPool::StealTask(Thread& victim, Task& task, size_t priority)
 {
-    SpawnThreads();
+    if (victim.queuedTasks[priority].load() == 0)
+    {
+        return false;
+    }
+
+    LockGuard lock(victim.tasksMutex);
+    if (victim.tasks[priority].PopBack(task))
+    {
+        victim.queuedTasks[priority].fetch_sub(1);
+        return true;
+    }
+
+    return false;
 }
 
-ThreadPool::~ThreadPool()
+void ThreadPool::WakeWorkerThreads(size_t count)
 {
-    WaitForTasks();
+    // sleeping workers (and helping waiters) check mQueuedTasks under
+    // mPoolStateMutex before they go to sleep, so if nobody sleeps at this
+    // point we can skip locking
+    const bool wakeWaitingThreads = (mWaitingThreads.load() > 0);
+    if (mSleepingWorkerThreads.load() == 0 && !wakeWaitingThreads)
+    {
+        return;
+    }
 
     {
         LockGuard lock(mPoolStateMutex);
-        mExitFlag = true; // enables flag, which will purge the thread pool
     }
-    mDispatchThreadCV.notify_all();
 
-    // first, leave dispatch thread
-    mDispatchThread.join();
+    if (wakeWaitingThreads)
+    {
+        mTasksDoneCV.notify_all();
+    }
 
-    // now all tasks should be dispatched, wait for each of worker threads
-    for (auto& t: mWorkerThreads)
+    if (count >= mWorkerThreadCount.load())
     {
-        if (t.thread.joinable())
+        mTaskAvailableCV.notify_all();
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
         {
-            t.taskReadyCV.notify_all();
-            t.thread.join();
+            mTaskAvailableCV.notify_one();
         }
     }
 }
 
-void ThreadPool::SpawnThreads()
+void ThreadPool::RecordSubmittedTasks(size_t count, size_t queuedTasks)
 {
-    mDispatchThread = std::thread(&ThreadPool::DispatchThreadFunction, this);
+    mTasksSubmitted.fetch_add(count, std::memory_order_relaxed);
 
-    uint16_t tidCounter = 0;
-    for (auto& t: mWorkerThreads)
+    size_t highWaterMark = mQueueHighWaterMark.load(std::memory_order_relaxed);
+    while (queuedTasks > highWaterMark &&
+           !mQueueHighWaterMark.compare_exchange_weak(highWaterMark, queuedTasks, std::memory_order_relaxed))
     {
-        t.payload.tid = tidCounter;
-        t.thread = std::thread(&ThreadPool::WorkerThreadFunction, this, std::ref(t));
-        tidCounter++;
     }
+}
 
+void ThreadPool::ExecuteTask(Task& task, ThreadPayload& payload, Thread* self)
+{
+    if (!IsStatisticsEnabled())
     {
-        UniqueLock lock(mPoolStateMutex);
-        mStartupStateCV.wait(lock, [this]() {
-            return (mAvailableWorkerThreads == mWorkerThreads.size());
-        });
+        task(payload);
+        FinishTask(task);
+        return;
     }
+
+    Impl::ThreadStatistics& stats = (self != nullptr) ? self->statistics : mExternalThreadStatistics;
+
+    const uint64_t startTime = GetTimestamp();
+    task(payload);
+    stats.RecordTask(task.submitTime, startTime, GetTimestamp());
+
+    FinishTask(task);
 }
 
-void ThreadPool::DispatchThreadFunction()
+void ThreadPool::FinishTask(Task& task)
 {
-    LOGD("Dispatch thread started");
+    // group is notified before callback is released - callback might hold the
+    // last reference to an object owning the group (ex. TaskFuture's state)
+    bool groupDone = false;
+    if (task.group != nullptr)
+    {
+        groupDone = task.group->FinishTask();
+        task.group = nullptr;
+    }
+    task.Reset();
 
-    while (true)
+    // waiters from inside of tasks are done once only suspended tasks remain
+    const size_t remainingTasks = mActiveTasks.fetch_sub(1) - 1;
+    if (remainingTasks <= mSuspendedTasks.load() ||
+        (groupDone && mWaitingThreads.load() > 0))
     {
-        {
-            UniqueLock dispatchThreadLock(mPoolStateMutex);
-            mDispatchThreadCV.wait(dispatchThreadLock, [this]
-            {
-                return ((!mTaskQueue.empty()) && (mAvailableWorkerThreads > 0)) || mExitFlag;
-            });
-        }
+        NotifyWaitingThreads();
+    }
+}
+
+void ThreadPool::NotifyWaitingThreads()
+{
+    LockGuard lock(mPoolStateMutex);
+    mTasksDoneCV.notify_all();
+}
+
+template <typename Predicate>
+void ThreadPool::WaitUntil(ThreadPayload* helperPayload, Predicate&& isDone)
+{
+    Thread* self = (tCurrentPool == this) ? tCurrentThread : nullptr;
 
-        if (mExitFlag && mTaskQueue.empty() && mAvailableWorkerThreads == mWorkerThreads.size())
+    Task task;
+    while (!isDone())
+    {
+        if (helperPayload != nullptr && PopTask(self, task))
         {
-            mTasksDoneCV.notify_all();
-            break;
+            ExecuteTask(task, *helperPayload, self);
+            continue;
         }
 
-        // TODO THIS MIGHT SPIN-LOOP DISPATCH THREAD
-        // Situation where ExitFlag == true and there are no working threads available,
-        // then CV above will never wait. Try to avoid that.
-        if (mAvailableWorkerThreads > 0 && !mTaskQueue.empty())
-        {
-            // get first free thread (should be available)
-            uint32_t thread = 0;
-            for (thread; thread < mWorkerThreads.size(); ++thread)
-            {
-                if (mWorkerThreads[thread].taskReady == false)
-                {
-                    break;
-                }
-            }
+        // waiting thread is counted before checking the predicate, so whoever
+        // changes the state after our check will see us and notify
+        UniqueLock lock(mPoolStateMutex);
+        mWaitingThreads.fetch_add(1);
+        mTasksDoneCV.wait(lock, [this, helperPayload, &isDone]() {
+            return isDone() || (helperPayload != nullptr && mQueuedTasks.load() > 0);
+        });
+        mWaitingThreads.fetch_sub(1);
+    }
+}
 
-            // if there's no free thread, programmer screwed up =(
-            LKCOMMON_ASSERT(thread != mWorkerThreads.size(), "There should exist a free thread on this stage of dispatcher loop");
+template <typename Predicate>
+void ThreadPool::WaitInsideTask(Predicate&& isDone)
+{
+    // calling task cannot finish before the wait is over, so it is excluded
+    // from tasks which WaitForTasks() waits for
+    if (mSuspendedTasks.fetch_add(1) + 1 >= mActiveTasks.load())
+    {
+        NotifyWaitingThreads();
+    }
 
-            // prepare the thread
-            Thread& t = mWorkerThreads[thread];
+    WaitUntil(&tCurrentThread->payload, std::forward<Predicate>(isDone));
 
-            // assign a task from queue and update das
-            {
-                LockGuard lock(mPoolStateMutex);
+    mSuspendedTasks.fetch_sub(1);
+}
 
-                mAvailableWorkerThreads--;
-                t.assignedTask = std::move(mTaskQueue.front());
-                mTaskQueue.pop();
-            }
+bool ThreadPool::WaitForQueuedTasks(Thread& self)
+{
+    // only reads the counter - its cache line stays shared between idle
+    // workers until someone actually queues a task
+    const uint32_t spinCount = mIdleSpinCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < spinCount; ++i)
+    {
+        if (mQueuedTasks.load(std::memory_order_relaxed) > 0 || self.retired.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
 
-            {
-                LockGuard lock(t.stateMutex);
-                t.taskReady = true;
-            }
+        _mm_pause();
+    }
 
-            t.taskReadyCV.notify_all();
+    const uint32_t yieldCount = mIdleYieldCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < yieldCount; ++i)
+    {
+        if (mQueuedTasks.load(std::memory_order_relaxed) > 0 || self.retired.load(std::memory_order_relaxed))
+        {
+            return true;
         }
+
+        std::this_thread::yield();
     }
 
-    LOGD("Dispatch thread stopped");
+    return false;
 }
 
 void ThreadPool::WorkerThreadFunction(Thread& self)
 {
     LOGD(self.payload.tid << ": Worker thread started");
 
+    tCurrentPool = this;
+    tCurrentThread = &self;
+
+    if (self.cpu != Thread::NO_CPU)
+    {
+        if (!System::Affinity::PinCurrentThread(self.cpu))
+        {
+            self.cpu = Thread::NO_CPU;
+        }
+    }
+
     {
         LockGuard lock(mPoolStateMutex);
-        mAvailableWorkerThreads++;
+        mStartedWorkerThreads++;
         mStartupStateCV.notify_all();
     }
 
+    Task task;
+    // idle period is ended on every way out of it, even if statistics were
+    // disabled in the meantime
+    bool idle = false;
     while (true)
     {
+        if (self.retired.load())
         {
-            UniqueLock cvLock(self.stateMutex);
-            self.taskReadyCV.wait(cvLock, [this, &self]() {
-                return (self.taskReady == true) || (mExitFlag == true);
-            });
+            // finish tasks which landed on us before retirement and leave
+            if (PopOwnTask(self, task))
+            {
+                if (idle)
+                {
+                    self.statistics.EndIdle(GetTimestamp());
+                    idle = false;
+                }
+
+                ExecuteTask(task, self.payload, &self);
+                continue;
+            }
+
+            break;
         }
 
-        if (mExitFlag)
+        if (PopTask(&self, task))
         {
-            break;
+            if (idle)
+            {
+                self.statistics.EndIdle(GetTimestamp());
+                idle = false;
+            }
+
+            // do the thing we are meant to do
+            ExecuteTask(task, self.payload, &self);
+            continue;
         }
 
-        // do the thing we are meant to do
-        self.assignedTask.function(self.payload);
+        if (!idle && IsStatisticsEnabled())
+        {
+            self.statistics.BeginIdle(GetTimestamp());
+            idle = true;
+        }
 
-        // mark the thread as free to do other tasks
+        // nothing to do here and nothing to steal - wait a bit in case more
+        // work arrives shortly, then go to sleep
+        if (WaitForQueuedTasks(self))
         {
-            LockGuard lock(self.stateMutex);
-            self.taskReady = false;
+            continue;
         }
 
         {
-            LockGuard lock(mPoolStateMutex);
-            mAvailableWorkerThreads++;
+            UniqueLock lock(mPoolStateMutex);
+            mSleepingWorkerThreads.fetch_add(1);
+            mTaskAvailableCV.wait(lock, [this, &self]() {
+                return (mQueuedTasks.load() > 0) || mExitFlag || self.retired.load();
+            });
+            mSleepingWorkerThreads.fetch_sub(1);
 
-            if (mAvailableWorkerThreads == mWorkerThreads.size())
-                mTasksDoneCV.notify_all();
+            if (mExitFlag && (mQueuedTasks.load() == 0))
+            {
+                break;
+            }
         }
+    }
 
-        // notify dispatcher that we are done
-        mDispatchThreadCV.notify_all();
+    if (idle)
+    {
+        self.statistics.EndIdle(GetTimestamp());
     }
 
+    tCurrentPool = nullptr;
+    tCurrentThread = nullptr;
+
     LOGD(self.payload.tid << ": Worker thread stopped");
 }
 
 void ThreadPool::SetUserPayloadForThread(uint16_t pid, void* payloadPtr)
 {
-    LKCOMMON_ASSERT(pid < mWorkerThreads.size(), "Provided PID is too high - thread does not exist");
+    LKCOMMON_ASSERT(pid < GetWorkerThreadCount(), "Provided PID is too high - thread does not exist");
+
+    mWorkerThreads[pid]->payload.userData = payloadPtr;
+}
+
+void ThreadPool::SetWorkerIdlePolicy(const WorkerIdlePolicy& policy)
+{
+    mIdleSpinCount.store(policy.spinCount);
+    mIdleYieldCount.store(policy.yieldCount);
+}
 
-    mWorkerThreads[pid].payload.userData = payloadPtr;
+WorkerIdlePolicy ThreadPool::GetWorkerIdlePolicy() const
+{
+    return WorkerIdlePolicy(mIdleSpinCount.load(), mIdleYieldCount.load());
 }
 
-void ThreadPool::AddTask(TaskCallback&& callback)
+void ThreadPool::EnableStatistics(bool enable)
 {
+    mStatisticsEnabled.store(enable);
+
+    if (!enable)
     {
-        LockGuard lock(mPoolStateMutex);
-        mTaskQueue.emplace(std::move(callback));
+        // idle periods in progress must not be counted once statistics are
+        // back on
+        const size_t threadCount = mCreatedWorkerThreads.load();
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            mWorkerThreads[i]->statistics.CancelIdle();
+        }
+    }
+}
+
+ThreadPoolStatistics ThreadPool::GetStatistics() const
+{
+    const uint64_t now = GetTimestamp();
+
+    ThreadPoolStatistics stats;
+    stats.tasksSubmitted = mTasksSubmitted.load(std::memory_order_relaxed);
+    stats.queueHighWaterMark = mQueueHighWaterMark.load(std::memory_order_relaxed);
+
+    const size_t threadCount = mCreatedWorkerThreads.load();
+    stats.workers.resize(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        mWorkerThreads[i]->statistics.Collect(stats, stats.workers[i], now);
+    }
+    mExternalThreadStatistics.Collect(stats, stats.externalThreads, now);
+
+    return stats;
+}
+
+void ThreadPool::ResetStatistics()
+{
+    const uint64_t now = GetTimestamp();
+
+    mTasksSubmitted.store(0);
+    mQueueHighWaterMark.store(0);
+
+    const size_t threadCount = mCreatedWorkerThreads.load();
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        mWorkerThreads[i]->statistics.Reset(now);
+    }
+    mExternalThreadStatistics.Reset(now);
+}
+
+ThreadPayload* ThreadPool::GetCurrentWorkerPayload() const
+{
+    if (tCurrentPool == this)
+    {
+        return &tCurrentThread->payload;
     }
-    mDispatchThreadCV.notify_all();
+
+    return nullptr;
+}
+
+void ThreadPool::AddTask(TaskCallback&& callback, TaskPriority priority)
+{
+    PushTask(Task(std::move(callback)), priority);
+    WakeWorkerThreads(1);
+}
+
+void ThreadPool::AddTask(TaskCallback&& callback, TaskGroup& group, TaskPriority priority)
+{
+    PushTask(Task(std::move(callback), &group), priority);
+    WakeWorkerThreads(1);
+}
+
+void ThreadPool::SubmitTasks(std::vector<TaskCallback>& callbacks, TaskGroup* group, TaskPriority priority)
+{
+    PushTasks(callbacks.size(), group, priority, [&callbacks, group](size_t i) {
+        return Task(std::move(callbacks[i]), group);
+    });
+    WakeWorkerThreads(callbacks.size());
+}
+
+void ThreadPool::SubmitTasks(size_t count, IndexedTaskCallback& callback, TaskGroup* group,
+                             TaskPriority priority)
+{
+    // all tasks in the batch share one copy of user's callback
+    std::shared_ptr<IndexedTaskCallback> sharedCallback =
+        std::make_shared<IndexedTaskCallback>(std::move(callback));
+
+    PushTasks(count, group, priority, [&sharedCallback, group](size_t i) {
+        return Task([sharedCallback, i](ThreadPayload& payload) {
+            (*sharedCallback)(payload, i);
+        }, group);
+    });
+    WakeWorkerThreads(count);
+}
+
+void ThreadPool::AddTasks(std::vector<TaskCallback>&& callbacks, TaskPriority priority)
+{
+    SubmitTasks(callbacks, nullptr, priority);
+}
+
+void ThreadPool::AddTasks(std::vector<TaskCallback>&& callbacks, TaskGroup& group, TaskPriority priority)
+{
+    SubmitTasks(callbacks, &group, priority);
+}
+
+void ThreadPool::AddTasks(size_t count, IndexedTaskCallback&& callback, TaskPriority priority)
+{
+    SubmitTasks(count, callback, nullptr, priority);
+}
+
+void ThreadPool::AddTasks(size_t count, IndexedTaskCallback&& callback, TaskGroup& group,
+                          TaskPriority priority)
+{
+    SubmitTasks(count, callback, &group, priority);
 }
 
 void ThreadPool::WaitForTasks()
 {
-    UniqueLock lock(mPoolStateMutex);
-    mTasksDoneCV.wait(lock, [this]
+    if (tCurrentPool == this)
+    {
+        WaitInsideTask([this]() {
+            return (mActiveTasks.load() <= mSuspendedTasks.load());
+        });
+        return;
+    }
+
+    WaitUntil(nullptr, [this]() {
+        return (mActiveTasks.load() == 0);
+    });
+}
+
+void ThreadPool::WaitForTasks(ThreadPayload& payload)
+{
+    if (tCurrentPool == this)
+    {
+        WaitForTasks();
+        return;
+    }
+
+    WaitUntil(&payload, [this]() {
+        return (mActiveTasks.load() == 0);
+    });
+}
+
+void ThreadPool::WaitForTasks(TaskGroup& group)
+{
+    if (tCurrentPool == this)
+    {
+        WaitInsideTask([&group]() {
+            return group.IsDone();
+        });
+        return;
+    }
+
+    WaitUntil(nullptr, [&group]() {
+        return group.IsDone();
+    });
+}
+
+void ThreadPool::WaitForTasks(TaskGroup& group, ThreadPayload& payload)
+{
+    if (tCurrentPool == this)
     {
-        return (mTaskQueue.empty()) && (mAvailableWorkerThreads == mWorkerThreads.size());
+        WaitForTasks(group);
+        return;
+    }
+
+    WaitUntil(&payload, [&group]() {
+        return group.IsDone();
     });
 }
 
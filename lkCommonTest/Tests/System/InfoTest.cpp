@@ -10,3 +10,37 @@ TEST(Info, PageSize)
 {
     EXPECT_GT(lkCommon::System::Info::GetPageSize(), 0u);
 }
+
+TEST(Info, CPUTopology)
+{
+    lkCommon::System::Info::CPUTopology topology = lkCommon::System::Info::GetCPUTopology();
+
+    ASSERT_FALSE(topology.empty());
+    EXPECT_LE(topology.size(), lkCommon::System::Info::GetCPUCount());
+
+    for (size_t i = 1; i < topology.size(); ++i)
+    {
+        EXPECT_LT(topology[i - 1].id, topology[i].id);
+    }
+}
+
+TEST(Info, PhysicalCoreCount)
+{
+    size_t cores = lkCommon::System::Info::GetPhysicalCoreCount();
+    EXPECT_GT(cores, 0u);
+    EXPECT_LE(cores, lkCommon::System::Info::GetCPUTopology().size());
+}
+
+TEST(Info, NUMANodeCount)
+{
+    size_t nodes = lkCommon::System::Info::GetNUMANodeCount();
+    EXPECT_GT(nodes, 0u);
+    EXPECT_LE(nodes, lkCommon::System::Info::GetPhysicalCoreCount());
+}
+
+TEST(Info, HugePageSize)
+{
+    size_t hugePageSize = lkCommon::System::Info::GetHugePageSize();
+    EXPECT_GE(hugePageSize, lkCommon::System::Info::GetPageSize());
+    EXPECT_EQ(0u, hugePageSize % lkCommon::System::Info::GetPageSize());
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <lkCommon/System/Info.hpp>
+#include <lkCommon/System/Memory.hpp>
+
+#include <cstdint>
+
+namespace {
+
+const size_t PAGE_SIZE = lkCommon::System::Info::GetPageSize();
+const size_t HUGE_PAGE_SIZE = lkCommon::System::Info::GetHugePageSize();
+
+bool IsZeroed(const uint8_t* ptr, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (ptr[i] != 0)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+
+TEST(Memory, AlignedAlloc)
+{
+    void* ptr = lkCommon::System::Memory::AlignedAlloc(PAGE_SIZE * 3, PAGE_SIZE);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % PAGE_SIZE);
+    memset(ptr, 1, PAGE_SIZE * 3);
+    lkCommon::System::Memory::AlignedFree(ptr);
+}
+
+TEST(Memory, MapMemory)
+{
+    const size_t size = PAGE_SIZE * 4;
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(lkCommon::System::Memory::MapMemory(size, false));
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % PAGE_SIZE);
+    EXPECT_TRUE(IsZeroed(ptr, size));
+
+    memset(ptr, 1, size);
+    lkCommon::System::Memory::UnmapMemory(ptr, size);
+}
+
+TEST(Memory, MapMemoryHugePages)
+{
+    const size_t size = HUGE_PAGE_SIZE * 2;
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(lkCommon::System::Memory::MapMemory(size, true));
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(ptr) % PAGE_SIZE);
+
+    // whole block is usable, regardless of pages backing it
+    memset(ptr, 1, size);
+    lkCommon::System::Memory::UnmapMemory(ptr, size);
+}
+
+TEST(Memory, DiscardMemory)
+{
+    const size_t size = PAGE_SIZE * 4;
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(lkCommon::System::Memory::MapMemory(size, false));
+    ASSERT_NE(nullptr, ptr);
+
+    memset(ptr, 1, size);
+    lkCommon::System::Memory::DiscardMemory(ptr + PAGE_SIZE, PAGE_SIZE * 2);
+
+    // only discarded pages lose their contents, memory stays usable
+    EXPECT_EQ(1, ptr[0]);
+    EXPECT_TRUE(IsZeroed(ptr + PAGE_SIZE, PAGE_SIZE * 2));
+    EXPECT_EQ(1, ptr[size - 1]);
+
+    memset(ptr, 2, size);
+    lkCommon::System::Memory::UnmapMemory(ptr, size);
+}
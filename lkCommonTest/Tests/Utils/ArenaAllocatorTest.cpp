@@ -2,6 +2,10 @@
 #include "lkCommon/System/Info.hpp"
 #include <gtest/gtest.h>
 #include <future>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 using namespace lkCommon::Utils;
 
@@ -212,3 +216,546 @@ TEST(ArenaAllocator, ClearUnusedChunks)
     ASSERT_EQ(1, allocator.GetChunkCount());
     ASSERT_EQ(chunkSize, allocator.GetFreeChunkSpace());
 }
+
+TEST(ArenaAllocator, AllocateFreeMultipleThreads)
+{
+    ArenaAllocator allocator;
+
+    const uint32_t ALLOCATION_COUNT = 10000;
+
+    auto threadFunc = [&allocator](uint32_t threadID) -> bool {
+        std::vector<uint32_t*> ptrs(ALLOCATION_COUNT);
+        for (uint32_t i = 0; i < ALLOCATION_COUNT; ++i)
+        {
+            ptrs[i] = reinterpret_cast<uint32_t*>(allocator.Allocate(ALLOCATION_SIZE_SMALL));
+            if (ptrs[i] == nullptr)
+                return false;
+
+            *ptrs[i] = threadID * ALLOCATION_COUNT + i;
+        }
+
+        // other threads could not have touched our allocations
+        bool valid = true;
+        for (uint32_t i = 0; i < ALLOCATION_COUNT; ++i)
+        {
+            valid &= (*ptrs[i] == threadID * ALLOCATION_COUNT + i);
+            allocator.Free(ptrs[i]);
+        }
+
+        return valid;
+    };
+
+    std::vector<std::future<bool>> futures;
+    for (uint32_t i = 0; i < THREAD_COUNT; ++i)
+    {
+        futures.emplace_back(std::async(std::launch::async, threadFunc, i));
+    }
+
+    for (auto& f: futures)
+    {
+        EXPECT_TRUE(f.get());
+    }
+}
+
+TEST(ArenaAllocator, ThreadCacheReleasedOnThreadExit)
+{
+    ArenaAllocator allocator;
+
+    // fill the first chunk, so thread's region lands in the second one
+    void* ptr = allocator.Allocate(PAGE_SIZE);
+    ASSERT_NE(nullptr, ptr);
+    ASSERT_EQ(1, allocator.GetChunkCount());
+    memset(ptr, 0, PAGE_SIZE); // in case we hit the same region as in previous run
+
+    std::thread t([&allocator]() {
+        void* small = allocator.Allocate(ALLOCATION_SIZE_SMALL);
+        ASSERT_NE(nullptr, small);
+        memset(small, 0, ALLOCATION_SIZE_SMALL);
+        allocator.Free(small);
+    });
+    t.join();
+
+    ASSERT_EQ(2, allocator.GetChunkCount());
+
+    allocator.Free(ptr);
+    allocator.ClearUnusedChunks();
+
+    // exited thread does not hold its region anymore - remaining chunk is totally free
+    EXPECT_EQ(1, allocator.GetChunkCount());
+    EXPECT_EQ(PAGE_SIZE * 2, allocator.GetFreeChunkSpace());
+}
+
+TEST(ArenaAllocator, ThreadCachesReleasedWithManyAllocators)
+{
+    // more allocators than thread remembers caches for
+    const size_t ALLOCATOR_COUNT = 10;
+
+    std::vector<std::unique_ptr<ArenaAllocator>> allocators;
+    std::vector<void*> ptrs;
+    for (size_t i = 0; i < ALLOCATOR_COUNT; ++i)
+    {
+        allocators.emplace_back(new ArenaAllocator());
+        ptrs.push_back(allocators.back()->Allocate(PAGE_SIZE));
+        ASSERT_NE(nullptr, ptrs.back());
+        memset(ptrs.back(), 0, PAGE_SIZE);
+    }
+
+    std::thread t([&allocators]() {
+        for (auto& allocator: allocators)
+        {
+            void* small = allocator->Allocate(ALLOCATION_SIZE_SMALL);
+            ASSERT_NE(nullptr, small);
+            memset(small, 0, ALLOCATION_SIZE_SMALL);
+            allocator->Free(small);
+        }
+    });
+    t.join();
+
+    // regions of caches evicted from thread's slots are released as well
+    for (size_t i = 0; i < ALLOCATOR_COUNT; ++i)
+    {
+        ASSERT_EQ(2, allocators[i]->GetChunkCount());
+
+        allocators[i]->Free(ptrs[i]);
+        allocators[i]->ClearUnusedChunks();
+
+        EXPECT_EQ(1, allocators[i]->GetChunkCount());
+        EXPECT_EQ(PAGE_SIZE * 2, allocators[i]->GetFreeChunkSpace());
+    }
+}
+
+TEST(ArenaAllocator, FreeManyChunks)
+{
+    ArenaAllocator allocator;
+
+    // each allocation fills its whole chunk, so every one lands in a separate chunk
+    const uint32_t CHUNK_COUNT = 12;
+    std::vector<void*> ptrs;
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i)
+    {
+        ptrs.push_back(allocator.Allocate(PAGE_SIZE << i));
+        ASSERT_NE(nullptr, ptrs.back());
+        memset(ptrs.back(), 0, sizeof(uint32_t)); // in case we hit the same region as in previous run
+    }
+
+    ASSERT_EQ(CHUNK_COUNT, allocator.GetChunkCount());
+
+    // free from other thread, out of order
+    std::thread t([&allocator, &ptrs]() {
+        for (size_t i = 0; i < ptrs.size(); i += 2)
+            allocator.Free(ptrs[i]);
+        for (size_t i = 1; i < ptrs.size(); i += 2)
+            allocator.Free(ptrs[i]);
+    });
+    t.join();
+
+    for (void* p: ptrs)
+    {
+        EXPECT_EQ(DEAD_AREA_MAGIC, *reinterpret_cast<uint32_t*>(p));
+    }
+
+    allocator.ClearUnusedChunks();
+    EXPECT_EQ(1, allocator.GetChunkCount());
+}
+
+TEST(ArenaAllocator, AllocateAligned)
+{
+    ArenaAllocator allocator;
+
+    // odd-sized allocation moves the next one off any alignment
+    ASSERT_NE(nullptr, allocator.Allocate(3));
+
+    const size_t alignments[] = { 16, 64, 256 };
+    for (size_t alignment: alignments)
+    {
+        void* ptr = allocator.Allocate(4 * sizeof(float), alignment);
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % alignment);
+        ASSERT_NE(nullptr, allocator.Allocate(1));
+    }
+
+    // alignment bigger than page size goes beyond what chunks are aligned to
+    void* ptr = allocator.Allocate(ALLOCATION_SIZE_SMALL, PAGE_SIZE * 4);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % (PAGE_SIZE * 4));
+}
+
+TEST(ArenaAllocator, AllocateNaturalAlignment)
+{
+    ArenaAllocator allocator;
+
+    ASSERT_NE(nullptr, allocator.Allocate(1));
+
+    // allocations are aligned according to their size...
+    void* ptr = allocator.Allocate(ALLOCATION_SIZE_SMALL);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % ALLOCATION_SIZE_SMALL);
+
+    ptr = allocator.Allocate(sizeof(uint32_t) * 3);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % sizeof(uint32_t));
+
+    // ...but odd sizes do not waste space
+    const size_t freeSpace = allocator.GetFreeChunkSpace();
+    ASSERT_NE(nullptr, allocator.Allocate(7));
+    EXPECT_EQ(freeSpace - 7, allocator.GetFreeChunkSpace());
+
+    EXPECT_EQ(16, ArenaAllocator::GetNaturalAlignment(48, 64));
+    EXPECT_EQ(64, ArenaAllocator::GetNaturalAlignment(128, 64));
+    EXPECT_EQ(1, ArenaAllocator::GetNaturalAlignment(7, 64));
+}
+
+TEST(ArenaAllocator, SmallObjectsReuseFreedBlocks)
+{
+    ArenaAllocator allocator(ArenaAllocatorMode::SMALL_OBJECTS);
+
+    // few enough to all stay on calling thread's free list
+    const size_t BLOCK_COUNT = 60;
+    const size_t BLOCK_SIZE = 40;
+
+    std::unordered_set<void*> blocks;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i)
+    {
+        void* ptr = allocator.Allocate(BLOCK_SIZE);
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % 16);
+        memset(ptr, 0, BLOCK_SIZE);
+        blocks.insert(ptr);
+    }
+
+    for (void* ptr: blocks)
+    {
+        allocator.Free(ptr);
+        EXPECT_EQ(DEAD_AREA_MAGIC, *reinterpret_cast<uint32_t*>(ptr));
+    }
+
+    // sizes rounding up to the same class get the freed blocks back
+    for (size_t i = 0; i < BLOCK_COUNT; ++i)
+    {
+        void* ptr = allocator.Allocate(BLOCK_SIZE + (i % 8));
+        EXPECT_EQ(1, blocks.count(ptr));
+        EXPECT_NE(DEAD_AREA_MAGIC, *reinterpret_cast<uint32_t*>(ptr));
+    }
+
+    // blocks of other classes and aligned blocks do not overlap the freed ones
+    for (size_t size = 16; size <= 256; size += 16)
+    {
+        void* ptr = allocator.Allocate(size, 64);
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % 64);
+        EXPECT_EQ(0, blocks.count(ptr));
+    }
+
+    // bigger allocations work as usual
+    void* ptr = allocator.Allocate(PAGE_SIZE);
+    ASSERT_NE(nullptr, ptr);
+    memset(ptr, 0, PAGE_SIZE);
+    allocator.Free(ptr);
+    EXPECT_EQ(DEAD_AREA_MAGIC, *reinterpret_cast<uint32_t*>(ptr));
+}
+
+TEST(ArenaAllocator, SmallObjectsChurnBoundsMemory)
+{
+    ArenaAllocator allocator(ArenaAllocatorMode::SMALL_OBJECTS);
+
+    const size_t ROUND_COUNT = 1000;
+    const size_t BLOCK_COUNT = 64;
+
+    std::vector<void*> ptrs(BLOCK_COUNT);
+    size_t chunkCount = 0;
+    for (size_t round = 0; round < ROUND_COUNT; ++round)
+    {
+        for (size_t i = 0; i < BLOCK_COUNT; ++i)
+        {
+            ptrs[i] = allocator.Allocate(8 + (i * 8) % 200);
+            ASSERT_NE(nullptr, ptrs[i]);
+            memset(ptrs[i], 0, sizeof(uint32_t));
+        }
+
+        for (void* ptr: ptrs)
+        {
+            allocator.Free(ptr);
+        }
+
+        // nothing new is needed after the first round
+        if (round == 0)
+            chunkCount = allocator.GetChunkCount();
+        ASSERT_EQ(chunkCount, allocator.GetChunkCount());
+    }
+}
+
+TEST(ArenaAllocator, SmallObjectsFreedByOtherThread)
+{
+    ArenaAllocator allocator(ArenaAllocatorMode::SMALL_OBJECTS);
+
+    const size_t BLOCK_COUNT = 10000;
+
+    std::vector<void*> ptrs(BLOCK_COUNT);
+    std::unordered_set<void*> blocks;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i)
+    {
+        ptrs[i] = allocator.Allocate(ALLOCATION_SIZE_SMALL);
+        ASSERT_NE(nullptr, ptrs[i]);
+        memset(ptrs[i], 0, ALLOCATION_SIZE_SMALL);
+        blocks.insert(ptrs[i]);
+    }
+
+    // freeing thread stays alive, so its free lists are not handed over on exit
+    std::promise<void> freed;
+    std::promise<void> finish;
+    std::thread t([&]() {
+        for (void* ptr: ptrs)
+            allocator.Free(ptr);
+
+        freed.set_value();
+        finish.get_future().wait();
+    });
+    freed.get_future().wait();
+
+    // blocks came back to allocator as freeing thread's list grew - only the rest of current page
+    // and what freeing thread kept for itself is taken from elsewhere
+    size_t reused = 0;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i)
+    {
+        void* ptr = allocator.Allocate(ALLOCATION_SIZE_SMALL);
+        ASSERT_NE(nullptr, ptr);
+        reused += blocks.count(ptr);
+    }
+
+    finish.set_value();
+    t.join();
+
+    EXPECT_LE(BLOCK_COUNT - PAGE_SIZE / ALLOCATION_SIZE_SMALL - 64, reused);
+}
+
+TEST(ArenaAllocator, MappedChunks)
+{
+    ArenaAllocator allocator(ArenaAllocatorMode::DEFAULT, ArenaChunkSource::MAPPED);
+
+    const uint32_t CHUNK_COUNT = 6;
+    std::vector<uint32_t*> ptrs;
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i)
+    {
+        ptrs.push_back(reinterpret_cast<uint32_t*>(allocator.Allocate(PAGE_SIZE << i)));
+        ASSERT_NE(nullptr, ptrs.back());
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptrs.back()) % PAGE_SIZE);
+
+        // mapped memory comes zeroed
+        EXPECT_EQ(0, *ptrs.back());
+        *ptrs.back() = i;
+    }
+
+    ASSERT_EQ(CHUNK_COUNT, allocator.GetChunkCount());
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i)
+    {
+        EXPECT_EQ(i, *ptrs[i]);
+        allocator.Free(ptrs[i]);
+    }
+
+    // active chunk is kept, but its memory is discarded
+    allocator.ClearUnusedChunks();
+    EXPECT_EQ(1, allocator.GetChunkCount());
+    EXPECT_EQ(0, *ptrs.back());
+
+    void* ptr = allocator.Allocate(ALLOCATION_SIZE_SMALL);
+    ASSERT_NE(nullptr, ptr);
+    allocator.Free(ptr);
+}
+
+TEST(ArenaAllocator, HugePageChunks)
+{
+    const size_t hugePageSize = lkCommon::System::Info::GetHugePageSize();
+
+    ArenaAllocator allocator(ArenaAllocatorMode::DEFAULT, ArenaChunkSource::MAPPED_HUGE_PAGES);
+
+    // small chunks are mapped with regular pages
+    void* small = allocator.Allocate(ALLOCATION_SIZE_SMALL);
+    ASSERT_NE(nullptr, small);
+    memset(small, 0, ALLOCATION_SIZE_SMALL);
+
+    // big allocation gets a chunk which spans whole huge pages
+    const size_t bigSize = hugePageSize + PAGE_SIZE;
+    uint8_t* big = reinterpret_cast<uint8_t*>(allocator.Allocate(bigSize));
+    ASSERT_NE(nullptr, big);
+    memset(big, 1, bigSize);
+    EXPECT_EQ(2, allocator.GetChunkCount());
+
+    allocator.Free(big);
+    allocator.Free(small);
+    allocator.ClearUnusedChunks();
+    EXPECT_EQ(1, allocator.GetChunkCount());
+    EXPECT_EQ(0, allocator.GetFreeChunkSpace() % hugePageSize);
+}
+
+TEST(ArenaAllocator, GrowthPolicyInitialSizeAndFactor)
+{
+    ArenaAllocator allocator;
+
+    ArenaGrowthPolicy policy;
+    policy.initialChunkSize = CUSTOM_CHUNK_SIZE_NOT_PADDED;
+    policy.growthFactor = 3.0f;
+    allocator.SetGrowthPolicy(policy);
+    EXPECT_EQ(3.0f, allocator.GetGrowthPolicy().growthFactor);
+
+    // initial size is padded to whole pages
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE, allocator.GetFreeChunkSpace());
+
+    void* first = allocator.Allocate(CUSTOM_CHUNK_SIZE);
+    ASSERT_NE(nullptr, first);
+    EXPECT_EQ(0, allocator.GetFreeChunkSpace());
+
+    void* second = allocator.Allocate(PAGE_SIZE);
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ(2, allocator.GetChunkCount());
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE * 3 - PAGE_SIZE, allocator.GetFreeChunkSpace());
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE * 4, allocator.GetTotalChunkSize());
+
+    memset(first, 0, CUSTOM_CHUNK_SIZE);
+    memset(second, 0, PAGE_SIZE);
+    allocator.Free(first);
+    allocator.Free(second);
+
+    // after freeing chunks allocator starts over from initial size
+    allocator.FreeChunks();
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE, allocator.GetFreeChunkSpace());
+    EXPECT_EQ(0, allocator.GetTotalChunkSize());
+}
+
+TEST(ArenaAllocator, GrowthPolicyMaxChunkSize)
+{
+    ArenaAllocator allocator;
+
+    ArenaGrowthPolicy policy;
+    policy.maxChunkSize = PAGE_SIZE * 2;
+    allocator.SetGrowthPolicy(policy);
+
+    std::vector<void*> ptrs;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        ptrs.push_back(allocator.Allocate(PAGE_SIZE));
+        ASSERT_NE(nullptr, ptrs.back());
+    }
+
+    // chunks of 1, 2 and 2 pages - growth stopped at max chunk size
+    EXPECT_EQ(3, allocator.GetChunkCount());
+    EXPECT_EQ(PAGE_SIZE * 5, allocator.GetTotalChunkSize());
+
+    // bigger allocations still fit, in chunks of their own
+    ptrs.push_back(allocator.Allocate(CUSTOM_CHUNK_SIZE));
+    ASSERT_NE(nullptr, ptrs.back());
+    EXPECT_EQ(4, allocator.GetChunkCount());
+    EXPECT_EQ(PAGE_SIZE * 5 + CUSTOM_CHUNK_SIZE, allocator.GetTotalChunkSize());
+
+    ptrs.push_back(allocator.Allocate(PAGE_SIZE));
+    ASSERT_NE(nullptr, ptrs.back());
+    EXPECT_EQ(5, allocator.GetChunkCount());
+    EXPECT_EQ(PAGE_SIZE * 7 + CUSTOM_CHUNK_SIZE, allocator.GetTotalChunkSize());
+
+    for (void* ptr: ptrs)
+    {
+        memset(ptr, 0, PAGE_SIZE);
+        allocator.Free(ptr);
+    }
+}
+
+TEST(ArenaAllocator, GrowthPolicyMemoryBudget)
+{
+    ArenaAllocator allocator;
+
+    size_t callbackRequestedSize = 0;
+    size_t callbackUsedSize = 0;
+    uint32_t callbackCount = 0;
+
+    ArenaGrowthPolicy policy;
+    policy.memoryBudget = CUSTOM_CHUNK_SIZE;
+    policy.budgetExceededCallback = [&](size_t requestedSize, size_t usedSize) {
+        callbackRequestedSize = requestedSize;
+        callbackUsedSize = usedSize;
+        callbackCount++;
+    };
+    allocator.SetGrowthPolicy(policy);
+
+    // chunks of 1 and 2 pages fit, third chunk shrinks to a single page to stay within budget
+    std::vector<void*> ptrs;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        ptrs.push_back(allocator.Allocate(PAGE_SIZE));
+        ASSERT_NE(nullptr, ptrs.back());
+        memset(ptrs.back(), 0, PAGE_SIZE);
+    }
+
+    EXPECT_EQ(3, allocator.GetChunkCount());
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE, allocator.GetTotalChunkSize());
+    EXPECT_EQ(0, callbackCount);
+
+    EXPECT_EQ(nullptr, allocator.Allocate(PAGE_SIZE));
+    EXPECT_EQ(1, callbackCount);
+    EXPECT_EQ(PAGE_SIZE, callbackRequestedSize);
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE, callbackUsedSize);
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE, allocator.GetTotalChunkSize());
+
+    // freeing whole first chunk makes room for another one
+    allocator.Free(ptrs[0]);
+    void* ptr = allocator.Allocate(PAGE_SIZE);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(1, callbackCount);
+    EXPECT_EQ(3, allocator.GetChunkCount());
+    EXPECT_EQ(CUSTOM_CHUNK_SIZE, allocator.GetTotalChunkSize());
+
+    memset(ptr, 0, PAGE_SIZE);
+    allocator.Free(ptr);
+    for (uint32_t i = 1; i < 4; ++i)
+    {
+        allocator.Free(ptrs[i]);
+    }
+}
+
+TEST(ArenaAllocator, GrowthPolicyFailedAllocationsKeepChunkSize)
+{
+    ArenaAllocator allocator;
+
+    ArenaGrowthPolicy policy;
+    policy.memoryBudget = CUSTOM_CHUNK_SIZE;
+    allocator.SetGrowthPolicy(policy);
+
+    // chunks of 1 and 2 pages, then a single page one squeezed into the budget
+    std::vector<void*> ptrs;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        ptrs.push_back(allocator.Allocate(PAGE_SIZE));
+        ASSERT_NE(nullptr, ptrs.back());
+        memset(ptrs.back(), 0, PAGE_SIZE);
+    }
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(nullptr, allocator.Allocate(PAGE_SIZE));
+    }
+
+    for (void* ptr: ptrs)
+    {
+        allocator.Free(ptr);
+    }
+    ptrs.clear();
+
+    // only the active single page chunk is left
+    allocator.ClearUnusedChunks();
+    ASSERT_EQ(1, allocator.GetChunkCount());
+    ASSERT_EQ(PAGE_SIZE, allocator.GetTotalChunkSize());
+
+    ptrs.push_back(allocator.Allocate(PAGE_SIZE));
+    ASSERT_NE(nullptr, ptrs.back());
+
+    // growth continues from the last chunk, as if failed allocations never happened
+    ptrs.push_back(allocator.Allocate(PAGE_SIZE));
+    ASSERT_NE(nullptr, ptrs.back());
+    EXPECT_EQ(2, allocator.GetChunkCount());
+    EXPECT_EQ(PAGE_SIZE * 3, allocator.GetTotalChunkSize());
+    EXPECT_EQ(PAGE_SIZE, allocator.GetFreeChunkSpace());
+
+    for (void* ptr: ptrs)
+    {
+        memset(ptr, 0, PAGE_SIZE);
+        allocator.Free(ptr);
+    }
+}
@@ -23,6 +23,17 @@ public:
     }
 };
 
+struct alignas(16) AlignedObject: public ArenaObject
+{
+    float v[4];
+};
+
+class ByteObject: public ArenaObject
+{
+public:
+    uint8_t mByte[3];
+};
+
 const uint32_t VALUE_A = 0x0000000F;
 const uint32_t VALUE_B = 42;
 
@@ -45,3 +56,19 @@ TEST(ArenaObject, CreateObject)
 
     EXPECT_EQ(DEAD_AREA_MAGIC, *(reinterpret_cast<uint32_t*>(a)));
 }
+
+TEST(ArenaObject, CreateAlignedObject)
+{
+    ArenaAllocator allocator;
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        // odd-sized object makes allocator's space unaligned for the next one
+        ByteObject* b = new (allocator) ByteObject;
+        ASSERT_NE(nullptr, b);
+
+        AlignedObject* a = new (allocator) AlignedObject;
+        ASSERT_NE(nullptr, a);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a) % alignof(AlignedObject));
+    }
+}
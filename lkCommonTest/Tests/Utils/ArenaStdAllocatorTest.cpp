@@ -0,0 +1,146 @@
+#include "lkCommon/Utils/ArenaStdAllocator.hpp"
+#include <gtest/gtest.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace lkCommon::Utils;
+
+namespace {
+
+const size_t ELEMENT_COUNT = 1000;
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaStdAllocator<T>>;
+
+template <typename K, typename V>
+using ArenaUnorderedMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                             ArenaStdAllocator<std::pair<const K, V>>>;
+
+} // namespace
+
+
+TEST(ArenaStdAllocator, Equality)
+{
+    ArenaAllocator arena;
+    ArenaAllocator otherArena;
+
+    ArenaStdAllocator<int> a(arena);
+    ArenaStdAllocator<double> b(a);
+    ArenaStdAllocator<int> c(otherArena);
+
+    EXPECT_TRUE(a == b);
+    EXPECT_FALSE(a != b);
+    EXPECT_TRUE(a != c);
+    EXPECT_EQ(&arena, &b.GetArenaAllocator());
+}
+
+TEST(ArenaStdAllocator, Vector)
+{
+    ArenaAllocator arena;
+    ArenaVector<uint32_t> v{ArenaStdAllocator<uint32_t>(arena)};
+
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        v.push_back(i);
+    }
+
+    EXPECT_LE(1, arena.GetChunkCount());
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        EXPECT_EQ(i, v[i]);
+    }
+
+    // moved-to vector takes the adapter along
+    ArenaVector<uint32_t> moved(std::move(v));
+    EXPECT_EQ(&arena, &moved.get_allocator().GetArenaAllocator());
+    EXPECT_EQ(ELEMENT_COUNT, moved.size());
+}
+
+TEST(ArenaStdAllocator, AlignedVector)
+{
+    struct alignas(32) Aligned
+    {
+        float data[8];
+    };
+
+    ArenaAllocator arena;
+    ASSERT_NE(nullptr, arena.Allocate(1));
+
+    ArenaVector<Aligned> v{ArenaStdAllocator<Aligned>(arena)};
+    v.resize(16);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(v.data()) % alignof(Aligned));
+}
+
+TEST(ArenaStdAllocator, UnorderedMap)
+{
+    ArenaAllocator arena;
+    ArenaUnorderedMap<uint32_t, std::string> m{0, std::hash<uint32_t>(), std::equal_to<uint32_t>(),
+                                                ArenaStdAllocator<std::pair<const uint32_t, std::string>>(arena)};
+
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        m.emplace(i, std::to_string(i));
+    }
+
+    for (uint32_t i = 0; i < ELEMENT_COUNT; i += 2)
+    {
+        m.erase(i);
+    }
+
+    EXPECT_EQ(ELEMENT_COUNT / 2, m.size());
+    for (uint32_t i = 1; i < ELEMENT_COUNT; i += 2)
+    {
+        auto it = m.find(i);
+        ASSERT_NE(m.end(), it);
+        EXPECT_EQ(std::to_string(i), it->second);
+    }
+}
+
+TEST(ArenaStdAllocator, List)
+{
+    ArenaAllocator arena(ArenaAllocatorMode::SMALL_OBJECTS);
+    std::list<uint64_t, ArenaStdAllocator<uint64_t>> l{ArenaStdAllocator<uint64_t>(arena)};
+
+    // list nodes churn through size classes without growing the arena
+    size_t chunkCount = 0;
+    for (uint32_t round = 0; round < 10; ++round)
+    {
+        for (uint64_t i = 0; i < ELEMENT_COUNT; ++i)
+        {
+            l.push_back(i);
+        }
+
+        l.clear();
+
+        if (round == 0)
+            chunkCount = arena.GetChunkCount();
+        EXPECT_EQ(chunkCount, arena.GetChunkCount());
+    }
+}
+
+#ifdef __cpp_lib_memory_resource
+
+TEST(ArenaStdAllocator, MemoryResource)
+{
+    ArenaAllocator arena;
+    ArenaMemoryResource resource(arena);
+    ArenaMemoryResource otherResource(arena);
+
+    EXPECT_TRUE(resource.is_equal(otherResource));
+
+    std::pmr::vector<uint32_t> v(&resource);
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        v.push_back(i);
+    }
+
+    EXPECT_LE(1, arena.GetChunkCount());
+    for (uint32_t i = 0; i < ELEMENT_COUNT; ++i)
+    {
+        EXPECT_EQ(i, v[i]);
+    }
+}
+
+#endif // __cpp_lib_memory_resource
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <lkCommon/Utils/AsyncTask.hpp>
+
+// AsyncTask requires C++20 coroutines, test it only if they are available
+#if LKCOMMON_HAS_COROUTINES
+
+#include <atomic>
+#include <vector>
+
+using namespace lkCommon::Utils;
+
+namespace {
+
+const uint32_t ASYNC_TASK_COUNT = 100;
+
+AsyncTask<uint32_t> Double(ThreadPool& pool, uint32_t value)
+{
+    co_await ScheduleOn(pool);
+    co_return value * 2;
+}
+
+AsyncTask<uint32_t> SumOfDoubles(ThreadPool& pool, uint32_t count)
+{
+    std::vector<AsyncTask<uint32_t>> tasks;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        tasks.push_back(Double(pool, i));
+    }
+
+    uint32_t sum = 0;
+    for (auto& t: tasks)
+    {
+        sum += co_await std::move(t);
+    }
+
+    co_return sum;
+}
+
+} // namespace
+
+
+TEST(AsyncTask, ScheduleOn)
+{
+    ThreadPool tp(2);
+
+    auto coroutine = [](ThreadPool& pool) -> AsyncTask<bool> {
+        ThreadPayload& payload = co_await ScheduleOn(pool);
+        co_return (pool.GetCurrentWorkerPayload() == &payload) && (payload.tid < pool.GetWorkerThreadCount());
+    };
+
+    EXPECT_TRUE(SyncWait(coroutine(tp)));
+}
+
+TEST(AsyncTask, Chain)
+{
+    ThreadPool tp(4);
+
+    EXPECT_EQ(2u * (ASYNC_TASK_COUNT * (ASYNC_TASK_COUNT - 1) / 2), SyncWait(SumOfDoubles(tp, ASYNC_TASK_COUNT)));
+}
+
+TEST(AsyncTask, RunAsync)
+{
+    ThreadPool tp(2);
+    std::atomic<uint32_t> counter(0);
+
+    auto coroutine = [](ThreadPool& pool, std::atomic<uint32_t>& counter) -> AsyncTask<uint32_t> {
+        co_await RunAsync(pool, [&counter](ThreadPayload&) {
+            counter++;
+        });
+
+        uint32_t value = co_await RunAsync(pool, [](ThreadPayload&) -> uint32_t {
+            return 42;
+        }, TaskPriority::HIGH);
+
+        co_return value + counter.load();
+    };
+
+    EXPECT_EQ(43u, SyncWait(coroutine(tp, counter)));
+}
+
+TEST(AsyncTask, Void)
+{
+    ThreadPool tp(2);
+    std::atomic<bool> done(false);
+
+    auto coroutine = [](ThreadPool& pool, std::atomic<bool>& done) -> AsyncTask<> {
+        co_await ScheduleOn(pool);
+        done = true;
+    };
+
+    AsyncTask<> task = coroutine(tp, done);
+    EXPECT_TRUE(task.IsValid());
+    EXPECT_FALSE(task.IsDone());
+
+    SyncWait(std::move(task));
+    EXPECT_TRUE(done.load());
+}
+
+#endif // LKCOMMON_HAS_COROUTINES
@@ -0,0 +1,156 @@
+#include "lkCommon/Utils/FrameAllocator.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace lkCommon::Utils;
+
+namespace {
+
+const size_t BLOCK_SIZE = 1024;
+const size_t ALLOCATION_SIZE = 48;
+
+} // namespace
+
+
+TEST(FrameAllocator, Constructor)
+{
+    ArenaAllocator arena;
+    FrameAllocator allocator(arena, BLOCK_SIZE);
+    EXPECT_EQ(0, allocator.GetBlockCount());
+    EXPECT_EQ(0, arena.GetChunkCount());
+}
+
+TEST(FrameAllocator, Allocate)
+{
+    ArenaAllocator arena;
+    FrameAllocator allocator(arena, BLOCK_SIZE);
+
+    uint8_t* first = reinterpret_cast<uint8_t*>(allocator.Allocate(ALLOCATION_SIZE));
+    ASSERT_NE(nullptr, first);
+    memset(first, 0, ALLOCATION_SIZE);
+
+    // allocations are laid out one after another
+    uint8_t* second = reinterpret_cast<uint8_t*>(allocator.Allocate(ALLOCATION_SIZE));
+    ASSERT_NE(nullptr, second);
+    EXPECT_EQ(first + ALLOCATION_SIZE, second);
+    EXPECT_EQ(1, allocator.GetBlockCount());
+
+    void* aligned = allocator.Allocate(ALLOCATION_SIZE, 256);
+    ASSERT_NE(nullptr, aligned);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 256);
+}
+
+TEST(FrameAllocator, RewindToMarker)
+{
+    ArenaAllocator arena;
+    FrameAllocator allocator(arena, BLOCK_SIZE);
+
+    void* persistent = allocator.Allocate(ALLOCATION_SIZE);
+    ASSERT_NE(nullptr, persistent);
+    memset(persistent, 0, ALLOCATION_SIZE);
+
+    FrameAllocator::Marker marker = allocator.GetMarker();
+    void* first = allocator.Allocate(ALLOCATION_SIZE);
+    ASSERT_NE(nullptr, first);
+
+    // span multiple blocks
+    for (size_t i = 0; i < 100; ++i)
+    {
+        ASSERT_NE(nullptr, allocator.Allocate(ALLOCATION_SIZE));
+    }
+
+    const size_t blockCount = allocator.GetBlockCount();
+    EXPECT_LT(1, blockCount);
+
+    // memory after marker is given out again, blocks are kept
+    allocator.RewindTo(marker);
+    EXPECT_EQ(first, allocator.Allocate(ALLOCATION_SIZE));
+    EXPECT_EQ(blockCount, allocator.GetBlockCount());
+}
+
+TEST(FrameAllocator, Scope)
+{
+    ArenaAllocator arena;
+    FrameAllocator allocator(arena, BLOCK_SIZE);
+
+    void* first = nullptr;
+    {
+        FrameAllocator::Scope scope(allocator);
+        first = allocator.Allocate(ALLOCATION_SIZE);
+        ASSERT_NE(nullptr, first);
+        memset(first, 0, ALLOCATION_SIZE);
+
+        {
+            FrameAllocator::Scope nested(allocator);
+            ASSERT_NE(nullptr, allocator.Allocate(ALLOCATION_SIZE));
+        }
+
+        // nested scope released only its own allocation
+        EXPECT_EQ(reinterpret_cast<uint8_t*>(first) + ALLOCATION_SIZE, allocator.Allocate(ALLOCATION_SIZE));
+    }
+
+    EXPECT_EQ(first, allocator.Allocate(ALLOCATION_SIZE));
+}
+
+TEST(FrameAllocator, BlocksReusedAcrossFrames)
+{
+    ArenaAllocator arena;
+    FrameAllocator allocator(arena, BLOCK_SIZE);
+
+    const size_t FRAME_COUNT = 100;
+
+    size_t blockCount = 0;
+    size_t chunkCount = 0;
+    for (size_t frame = 0; frame < FRAME_COUNT; ++frame)
+    {
+        allocator.Reset();
+
+        void* big = allocator.Allocate(BLOCK_SIZE * 3);
+        ASSERT_NE(nullptr, big);
+        memset(big, 0, BLOCK_SIZE * 3);
+
+        for (size_t i = 0; i < 64; ++i)
+        {
+            void* ptr = allocator.Allocate(ALLOCATION_SIZE);
+            ASSERT_NE(nullptr, ptr);
+            memset(ptr, 0, ALLOCATION_SIZE);
+        }
+
+        // no frame after the first one needs any new memory
+        if (frame == 0)
+        {
+            blockCount = allocator.GetBlockCount();
+            chunkCount = arena.GetChunkCount();
+        }
+
+        ASSERT_EQ(blockCount, allocator.GetBlockCount());
+        ASSERT_EQ(chunkCount, arena.GetChunkCount());
+    }
+}
+
+TEST(FrameAllocator, ReleaseBlocks)
+{
+    ArenaAllocator arena;
+
+    {
+        FrameAllocator allocator(arena, BLOCK_SIZE);
+        for (size_t i = 0; i < 100; ++i)
+        {
+            void* ptr = allocator.Allocate(ALLOCATION_SIZE);
+            ASSERT_NE(nullptr, ptr);
+            memset(ptr, 0, ALLOCATION_SIZE);
+        }
+
+        allocator.ReleaseBlocks();
+        EXPECT_EQ(0, allocator.GetBlockCount());
+
+        // still usable afterwards
+        void* ptr = allocator.Allocate(ALLOCATION_SIZE);
+        ASSERT_NE(nullptr, ptr);
+        memset(ptr, 0, ALLOCATION_SIZE);
+    }
+
+    // all blocks went back to arena, so only the active chunk remains
+    arena.ClearUnusedChunks();
+    EXPECT_EQ(1, arena.GetChunkCount());
+}
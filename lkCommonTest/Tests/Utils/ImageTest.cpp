@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <lkCommon/Utils/Image.hpp>
+#include <lkCommon/Utils/ArenaStdAllocator.hpp>
 
 const uint32_t TEST_WIDTH = 10;
 const uint32_t TEST_HEIGHT = 20;
@@ -259,3 +260,34 @@ TEST(Image, SampleClosestCornerBilinear)
 
     EXPECT_EQ(TEST_PIXEL, p);
 }
+
+TEST(Image, ArenaAllocator)
+{
+    using ArenaPixelAllocator = lkCommon::Utils::ArenaStdAllocator<lkCommon::Utils::PixelUint4>;
+    using ArenaImage = lkCommon::Utils::Image<lkCommon::Utils::PixelUint4, ArenaPixelAllocator>;
+
+    lkCommon::Utils::ArenaAllocator arena;
+
+    {
+        ArenaImage i{ArenaPixelAllocator(arena)};
+        EXPECT_EQ(0, arena.GetChunkCount());
+
+        EXPECT_TRUE(i.Resize(TEST_WIDTH, TEST_HEIGHT));
+        EXPECT_EQ(1, arena.GetChunkCount());
+        EXPECT_TRUE(i.SetPixel(1, 2, TEST_PIXEL));
+
+        // copy takes its pixels from the same arena
+        const size_t freeSpace = arena.GetFreeChunkSpace();
+        ArenaImage copy(i);
+        EXPECT_GT(freeSpace, arena.GetFreeChunkSpace());
+        EXPECT_NE(i.GetDataPtr(), copy.GetDataPtr());
+
+        lkCommon::Utils::PixelUint4 p;
+        EXPECT_TRUE(copy.GetPixel(1, 2, p));
+        EXPECT_EQ(TEST_PIXEL, p);
+        EXPECT_TRUE(copy.Resize(TEST_WIDTH * 2, TEST_HEIGHT * 2));
+    }
+
+    arena.FreeChunks();
+    EXPECT_EQ(0, arena.GetChunkCount());
+}
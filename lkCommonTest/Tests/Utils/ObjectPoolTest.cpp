@@ -0,0 +1,155 @@
+#include "lkCommon/Utils/ObjectPool.hpp"
+#include <gtest/gtest.h>
+#include <unordered_set>
+#include <vector>
+
+using namespace lkCommon::Utils;
+
+namespace {
+
+const size_t SLOTS_PER_CHUNK = 16;
+
+struct Particle
+{
+    static int aliveCount;
+
+    float position[3];
+    float velocity[3];
+    int id;
+
+    Particle(int particleID = 0)
+        : position()
+        , velocity()
+        , id(particleID)
+    {
+        aliveCount++;
+    }
+
+    ~Particle()
+    {
+        aliveCount--;
+    }
+};
+
+int Particle::aliveCount = 0;
+
+} // namespace
+
+
+TEST(ObjectPool, Constructor)
+{
+    ArenaAllocator allocator;
+    ObjectPool<Particle> pool(allocator, SLOTS_PER_CHUNK);
+    EXPECT_EQ(0, pool.GetUsedCount());
+    EXPECT_EQ(0, pool.GetCapacity());
+    EXPECT_EQ(sizeof(Particle), pool.GetSlotSize());
+}
+
+TEST(ObjectPool, AcquireRelease)
+{
+    ArenaAllocator allocator;
+    ObjectPool<Particle> pool(allocator, SLOTS_PER_CHUNK);
+
+    Particle* p = pool.Acquire(5);
+    ASSERT_NE(nullptr, p);
+    EXPECT_EQ(5, p->id);
+    EXPECT_EQ(1, Particle::aliveCount);
+    EXPECT_EQ(1, pool.GetUsedCount());
+    EXPECT_EQ(SLOTS_PER_CHUNK, pool.GetCapacity());
+
+    pool.Release(p);
+    EXPECT_EQ(0, Particle::aliveCount);
+    EXPECT_EQ(0, pool.GetUsedCount());
+
+    // released slot is reused right away
+    EXPECT_EQ(p, pool.Acquire(6));
+    EXPECT_EQ(6, p->id);
+    pool.Release(p);
+}
+
+TEST(ObjectPool, AcquireManyChunks)
+{
+    ArenaAllocator allocator;
+    ObjectPool<Particle> pool(allocator, SLOTS_PER_CHUNK);
+
+    const size_t OBJECT_COUNT = SLOTS_PER_CHUNK * 10 + 1;
+
+    std::vector<Particle*> particles;
+    std::unordered_set<Particle*> unique;
+    for (size_t i = 0; i < OBJECT_COUNT; ++i)
+    {
+        particles.push_back(pool.Acquire(static_cast<int>(i)));
+        ASSERT_NE(nullptr, particles.back());
+        unique.insert(particles.back());
+    }
+
+    EXPECT_EQ(OBJECT_COUNT, unique.size());
+    EXPECT_EQ(SLOTS_PER_CHUNK * 11, pool.GetCapacity());
+
+    for (size_t i = 0; i < OBJECT_COUNT; ++i)
+    {
+        EXPECT_EQ(static_cast<int>(i), particles[i]->id);
+        pool.Release(particles[i]);
+    }
+
+    // released slots are enough for the same amount of objects
+    for (size_t i = 0; i < OBJECT_COUNT; ++i)
+    {
+        EXPECT_EQ(1, unique.count(pool.Acquire()));
+    }
+
+    EXPECT_EQ(SLOTS_PER_CHUNK * 11, pool.GetCapacity());
+    EXPECT_EQ(static_cast<int>(OBJECT_COUNT), Particle::aliveCount);
+
+    // objects which were not released are not destroyed with the pool
+    Particle::aliveCount = 0;
+}
+
+TEST(ObjectPool, CacheLineAligned)
+{
+    ArenaAllocator allocator;
+    ObjectPool<Particle, ObjectPool<Particle>::CACHE_LINE_SIZE> pool(allocator, SLOTS_PER_CHUNK);
+
+    EXPECT_EQ(ObjectPool<Particle>::CACHE_LINE_SIZE, pool.GetSlotSize());
+
+    std::vector<Particle*> particles;
+    for (size_t i = 0; i < SLOTS_PER_CHUNK * 2; ++i)
+    {
+        particles.push_back(pool.Acquire());
+        ASSERT_NE(nullptr, particles.back());
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(particles.back()) % ObjectPool<Particle>::CACHE_LINE_SIZE);
+    }
+
+    pool.ReleaseBulk(particles.data(), particles.size());
+    EXPECT_EQ(0, Particle::aliveCount);
+}
+
+TEST(ObjectPool, Bulk)
+{
+    ArenaAllocator allocator;
+    ObjectPool<Particle> pool(allocator, SLOTS_PER_CHUNK);
+
+    const size_t OBJECT_COUNT = SLOTS_PER_CHUNK * 3;
+
+    std::vector<Particle*> particles(OBJECT_COUNT);
+    EXPECT_EQ(OBJECT_COUNT, pool.AcquireBulk(particles.data(), OBJECT_COUNT, 7));
+    EXPECT_EQ(static_cast<int>(OBJECT_COUNT), Particle::aliveCount);
+    EXPECT_EQ(OBJECT_COUNT, pool.GetUsedCount());
+
+    for (Particle* p: particles)
+    {
+        EXPECT_EQ(7, p->id);
+    }
+
+    pool.ReleaseBulk(particles.data(), OBJECT_COUNT);
+    EXPECT_EQ(0, Particle::aliveCount);
+    EXPECT_EQ(0, pool.GetUsedCount());
+
+    // bulk release keeps order of slots for next bulk acquire
+    std::vector<Particle*> again(OBJECT_COUNT);
+    EXPECT_EQ(OBJECT_COUNT, pool.AcquireBulk(again.data(), OBJECT_COUNT));
+    EXPECT_EQ(particles, again);
+    EXPECT_EQ(SLOTS_PER_CHUNK * 3, pool.GetCapacity());
+
+    pool.ReleaseBulk(again.data(), OBJECT_COUNT);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <lkCommon/Utils/ParallelFor.hpp>
+
+#include <atomic>
+#include <vector>
+
+using namespace lkCommon::Utils;
+
+namespace {
+
+const size_t RANGE_SIZE = 10'000;
+const size_t GRAIN_SIZE = 64;
+const uint32_t AREA_WIDTH = 123;
+const uint32_t AREA_HEIGHT = 77;
+const uint32_t TILE_SIZE = 16;
+
+} // namespace
+
+
+TEST(ParallelFor, Range)
+{
+    std::vector<std::atomic<uint32_t>> hits(RANGE_SIZE);
+    for (auto& h: hits)
+        h = 0;
+
+    ThreadPool tp;
+
+    ParallelFor(tp, 0, RANGE_SIZE, GRAIN_SIZE, [&hits](ThreadPayload&, size_t i) {
+        hits[i]++;
+    });
+
+    for (size_t i = 0; i < RANGE_SIZE; ++i)
+    {
+        EXPECT_EQ(1u, hits[i].load());
+    }
+}
+
+TEST(ParallelFor, RangeOffsetAutoGrain)
+{
+    const size_t begin = 100;
+    std::vector<std::atomic<uint32_t>> hits(RANGE_SIZE);
+    for (auto& h: hits)
+        h = 0;
+
+    ThreadPool tp(3);
+
+    ParallelFor(tp, begin, RANGE_SIZE, 0, [&hits](ThreadPayload&, size_t i) {
+        hits[i]++;
+    });
+
+    for (size_t i = 0; i < RANGE_SIZE; ++i)
+    {
+        EXPECT_EQ((i < begin) ? 0u : 1u, hits[i].load());
+    }
+}
+
+TEST(ParallelFor, EmptyRange)
+{
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp(3);
+
+    ParallelFor(tp, 10, 10, GRAIN_SIZE, [&counter](ThreadPayload&, size_t) {
+        counter++;
+    });
+
+    EXPECT_EQ(0u, counter.load());
+}
+
+TEST(ParallelFor, Nested)
+{
+    const size_t outerCount = 8;
+    const size_t innerCount = 100;
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp(2);
+
+    ParallelFor(tp, 0, outerCount, 1, [&tp, &counter, innerCount](ThreadPayload&, size_t) {
+        ParallelFor(tp, 0, innerCount, 10, [&counter](ThreadPayload&, size_t) {
+            counter++;
+        });
+    });
+
+    EXPECT_EQ(outerCount * innerCount, counter.load());
+}
+
+TEST(ParallelFor, Payload)
+{
+    const uint32_t threadCount = 3;
+    std::vector<uint32_t> perThreadCounters(threadCount, 0);
+
+    ThreadPool tp(threadCount);
+    for (uint16_t i = 0; i < threadCount; ++i)
+    {
+        tp.SetUserPayloadForThread(i, &perThreadCounters[i]);
+    }
+
+    ParallelFor(tp, 0, RANGE_SIZE, GRAIN_SIZE, [](ThreadPayload& payload, size_t) {
+        uint32_t* counter = reinterpret_cast<uint32_t*>(payload.userData);
+        ASSERT_NE(nullptr, counter);
+        (*counter)++;
+    });
+
+    uint32_t sum = 0;
+    for (auto c: perThreadCounters)
+        sum += c;
+
+    EXPECT_EQ(RANGE_SIZE, sum);
+}
+
+TEST(ParallelFor, Tiles2D)
+{
+    std::vector<std::atomic<uint32_t>> hits(AREA_WIDTH * AREA_HEIGHT);
+    for (auto& h: hits)
+        h = 0;
+
+    ThreadPool tp;
+
+    ParallelFor2D(tp, AREA_WIDTH, AREA_HEIGHT, TILE_SIZE, TILE_SIZE,
+        [&hits](ThreadPayload&, uint32_t x, uint32_t y) {
+            ASSERT_LT(x, AREA_WIDTH);
+            ASSERT_LT(y, AREA_HEIGHT);
+            hits[y * AREA_WIDTH + x]++;
+        }
+    );
+
+    for (size_t i = 0; i < hits.size(); ++i)
+    {
+        EXPECT_EQ(1u, hits[i].load());
+    }
+}
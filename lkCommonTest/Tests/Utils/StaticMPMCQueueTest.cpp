@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <lkCommon/Utils/StaticMPMCQueue.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace lkCommon::Utils;
+
+const std::array<int, 6> TEST_VALUES = { 8, 2, 3, 5, 1, 9};
+
+
+TEST(StaticMPMCQueue, Create)
+{
+    StaticMPMCQueue<int, 16> q;
+    EXPECT_EQ(16, q.Capacity());
+    EXPECT_EQ(0, q.Size());
+    EXPECT_TRUE(q.IsEmpty());
+}
+
+TEST(StaticMPMCQueue, PushPop)
+{
+    StaticMPMCQueue<int, 16> q;
+
+    for (const auto& v: TEST_VALUES)
+    {
+        EXPECT_TRUE(q.TryPush(v));
+    }
+    EXPECT_EQ(TEST_VALUES.size(), q.Size());
+
+    for (const auto& v: TEST_VALUES)
+    {
+        int qv = 0;
+        EXPECT_TRUE(q.TryPop(qv));
+        EXPECT_EQ(v, qv);
+    }
+
+    int qv = 0;
+    EXPECT_FALSE(q.TryPop(qv));
+    EXPECT_TRUE(q.IsEmpty());
+}
+
+TEST(StaticMPMCQueue, EmplaceMoveOnly)
+{
+    StaticMPMCQueue<std::unique_ptr<int>, 8> q;
+
+    for (const auto& v: TEST_VALUES)
+    {
+        EXPECT_TRUE(q.TryEmplace(new int(v)));
+    }
+
+    for (const auto& v: TEST_VALUES)
+    {
+        std::unique_ptr<int> qv;
+        EXPECT_TRUE(q.TryPop(qv));
+        ASSERT_NE(nullptr, qv.get());
+        EXPECT_EQ(v, *qv);
+    }
+}
+
+TEST(StaticMPMCQueue, PushFull)
+{
+    StaticMPMCQueue<int, 4> q;
+
+    // wrap around the ring a couple of times
+    for (int lap = 0; lap < 3; ++lap)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_TRUE(q.TryPush(lap * 4 + i));
+        }
+
+        EXPECT_FALSE(q.TryPush(-1));
+        EXPECT_EQ(4, q.Size());
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int qv = 0;
+            EXPECT_TRUE(q.TryPop(qv));
+            EXPECT_EQ(lap * 4 + i, qv);
+        }
+    }
+}
+
+TEST(StaticMPMCQueue, DestroyNonEmpty)
+{
+    std::shared_ptr<int> value = std::make_shared<int>(1);
+
+    {
+        StaticMPMCQueue<std::shared_ptr<int>, 8> q;
+        EXPECT_TRUE(q.TryPush(value));
+        EXPECT_TRUE(q.TryPush(value));
+        EXPECT_EQ(3, value.use_count());
+    }
+
+    // remaining elements are destroyed with the queue
+    EXPECT_EQ(1, value.use_count());
+}
+
+TEST(StaticMPMCQueue, MultipleProducersConsumers)
+{
+    const uint32_t THREAD_COUNT = 4;
+    const uint32_t VALUES_PER_PRODUCER = 50000;
+
+    StaticMPMCQueue<uint32_t, 64> q;
+    std::atomic<uint64_t> sum(0);
+    std::atomic<uint32_t> popped(0);
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < THREAD_COUNT; ++t)
+    {
+        threads.emplace_back([&q]() {
+            for (uint32_t i = 1; i <= VALUES_PER_PRODUCER; ++i)
+            {
+                while (!q.TryPush(i))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        threads.emplace_back([&q, &sum, &popped]() {
+            const uint32_t total = THREAD_COUNT * VALUES_PER_PRODUCER;
+            uint32_t v;
+            while (popped.load() < total)
+            {
+                if (q.TryPop(v))
+                {
+                    sum += v;
+                    popped++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& t: threads)
+    {
+        t.join();
+    }
+
+    // every value was popped exactly once
+    const uint64_t producerSum = static_cast<uint64_t>(VALUES_PER_PRODUCER) * (VALUES_PER_PRODUCER + 1) / 2;
+    EXPECT_EQ(THREAD_COUNT * VALUES_PER_PRODUCER, popped.load());
+    EXPECT_EQ(THREAD_COUNT * producerSum, sum.load());
+    EXPECT_TRUE(q.IsEmpty());
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <lkCommon/Utils/StaticSPSCQueue.hpp>
+
+#include <array>
+#include <memory>
+#include <thread>
+
+using namespace lkCommon::Utils;
+
+const std::array<int, 6> TEST_VALUES = { 8, 2, 3, 5, 1, 9};
+
+
+TEST(StaticSPSCQueue, Create)
+{
+    StaticSPSCQueue<int, 16> q;
+    EXPECT_EQ(16, q.Capacity());
+    EXPECT_EQ(0, q.Size());
+    EXPECT_TRUE(q.IsEmpty());
+}
+
+TEST(StaticSPSCQueue, PushPop)
+{
+    StaticSPSCQueue<int, 16> q;
+
+    for (const auto& v: TEST_VALUES)
+    {
+        EXPECT_TRUE(q.TryPush(v));
+    }
+    EXPECT_EQ(TEST_VALUES.size(), q.Size());
+
+    for (const auto& v: TEST_VALUES)
+    {
+        int qv = 0;
+        EXPECT_TRUE(q.TryPop(qv));
+        EXPECT_EQ(v, qv);
+    }
+
+    int qv = 0;
+    EXPECT_FALSE(q.TryPop(qv));
+    EXPECT_TRUE(q.IsEmpty());
+}
+
+TEST(StaticSPSCQueue, EmplaceMoveOnly)
+{
+    StaticSPSCQueue<std::unique_ptr<int>, 8> q;
+
+    for (const auto& v: TEST_VALUES)
+    {
+        EXPECT_TRUE(q.TryEmplace(new int(v)));
+    }
+
+    for (const auto& v: TEST_VALUES)
+    {
+        std::unique_ptr<int> qv;
+        EXPECT_TRUE(q.TryPop(qv));
+        ASSERT_NE(nullptr, qv.get());
+        EXPECT_EQ(v, *qv);
+    }
+}
+
+TEST(StaticSPSCQueue, PushFull)
+{
+    StaticSPSCQueue<int, 4> q;
+
+    // wrap around the ring a couple of times
+    for (int lap = 0; lap < 3; ++lap)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            EXPECT_TRUE(q.TryPush(lap * 4 + i));
+        }
+
+        EXPECT_FALSE(q.TryPush(-1));
+        EXPECT_EQ(4, q.Size());
+
+        for (int i = 0; i < 4; ++i)
+        {
+            int qv = 0;
+            EXPECT_TRUE(q.TryPop(qv));
+            EXPECT_EQ(lap * 4 + i, qv);
+        }
+    }
+}
+
+TEST(StaticSPSCQueue, Batch)
+{
+    StaticSPSCQueue<int, 8> q;
+
+    // batch bigger than free space is pushed partially
+    EXPECT_EQ(TEST_VALUES.size(), q.TryPushBatch(TEST_VALUES.data(), TEST_VALUES.size()));
+    EXPECT_EQ(2, q.TryPushBatch(TEST_VALUES.data(), TEST_VALUES.size()));
+    EXPECT_EQ(0, q.TryPushBatch(TEST_VALUES.data(), TEST_VALUES.size()));
+    EXPECT_EQ(8, q.Size());
+
+    std::array<int, 16> popped;
+    EXPECT_EQ(4, q.TryPopBatch(popped.data(), 4));
+    EXPECT_EQ(4, q.TryPopBatch(popped.data() + 4, 12));
+    EXPECT_EQ(0, q.TryPopBatch(popped.data(), popped.size()));
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(TEST_VALUES[i % TEST_VALUES.size()], popped[i]);
+    }
+}
+
+TEST(StaticSPSCQueue, DestroyNonEmpty)
+{
+    std::shared_ptr<int> value = std::make_shared<int>(1);
+
+    {
+        StaticSPSCQueue<std::shared_ptr<int>, 8> q;
+        EXPECT_TRUE(q.TryPush(value));
+        EXPECT_TRUE(q.TryPush(value));
+        EXPECT_EQ(3, value.use_count());
+    }
+
+    // remaining elements are destroyed with the queue
+    EXPECT_EQ(1, value.use_count());
+}
+
+TEST(StaticSPSCQueue, ProducerConsumer)
+{
+    const uint32_t VALUE_COUNT = 100000;
+    const size_t BATCH_SIZE = 7;
+
+    StaticSPSCQueue<uint32_t, 64> q;
+
+    // producer mixes single and batch pushes, values have to come out in order
+    std::thread producer([&q]() {
+        uint32_t next = 0;
+        while (next < VALUE_COUNT)
+        {
+            if (next % 2 == 0)
+            {
+                uint32_t batch[BATCH_SIZE];
+                size_t count = 0;
+                for (; count < BATCH_SIZE && next + count < VALUE_COUNT; ++count)
+                {
+                    batch[count] = next + static_cast<uint32_t>(count);
+                }
+
+                const size_t pushed = q.TryPushBatch(batch, count);
+                next += static_cast<uint32_t>(pushed);
+                if (pushed == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            else if (q.TryPush(next))
+            {
+                next++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    uint32_t batch[BATCH_SIZE];
+    while (expected < VALUE_COUNT)
+    {
+        const size_t count = q.TryPopBatch(batch, BATCH_SIZE);
+        if (count == 0)
+        {
+            std::this_thread::yield();
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            EXPECT_EQ(expected, batch[i]);
+            expected++;
+        }
+    }
+
+    producer.join();
+    EXPECT_TRUE(q.IsEmpty());
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <lkCommon/Utils/TaskGraph.hpp>
+
+#include <atomic>
+#include <vector>
+
+using namespace lkCommon::Utils;
+
+namespace {
+
+const size_t CHAIN_LENGTH = 100;
+const size_t FAN_OUT_COUNT = 64;
+
+} // namespace
+
+
+TEST(TaskGraph, Empty)
+{
+    ThreadPool tp(2);
+    TaskGraph graph;
+
+    EXPECT_EQ(0, graph.GetTaskCount());
+    EXPECT_TRUE(graph.Run(tp));
+    graph.Wait();
+}
+
+TEST(TaskGraph, Diamond)
+{
+    std::atomic<uint32_t> order(0);
+    uint32_t a = 0, b = 0, c = 0, d = 0;
+
+    ThreadPool tp(3);
+    TaskGraph graph;
+
+    TaskGraph::NodeID idA = graph.AddTask([&](ThreadPayload&) { a = ++order; });
+    TaskGraph::NodeID idB = graph.AddTask([&](ThreadPayload&) { b = ++order; }, { idA });
+    TaskGraph::NodeID idC = graph.AddTask([&](ThreadPayload&) { c = ++order; }, { idA });
+    graph.AddTask([&](ThreadPayload&) { d = ++order; }, { idB, idC });
+
+    EXPECT_EQ(4, graph.GetTaskCount());
+    ASSERT_TRUE(graph.Run(tp));
+    graph.Wait();
+
+    EXPECT_EQ(1u, a);
+    EXPECT_LT(a, b);
+    EXPECT_LT(a, c);
+    EXPECT_EQ(4u, d);
+}
+
+TEST(TaskGraph, Chain)
+{
+    std::vector<size_t> visited;
+
+    ThreadPool tp;
+    TaskGraph graph;
+
+    TaskGraph::NodeID prev = graph.AddTask([&visited](ThreadPayload&) { visited.push_back(0); });
+    for (size_t i = 1; i < CHAIN_LENGTH; ++i)
+    {
+        prev = graph.AddTask([&visited, i](ThreadPayload&) { visited.push_back(i); }, { prev });
+    }
+
+    ASSERT_TRUE(graph.Run(tp));
+    graph.Wait();
+
+    ASSERT_EQ(CHAIN_LENGTH, visited.size());
+    for (size_t i = 0; i < CHAIN_LENGTH; ++i)
+    {
+        EXPECT_EQ(i, visited[i]);
+    }
+}
+
+TEST(TaskGraph, FanOutFanIn)
+{
+    std::atomic<uint32_t> counter(0);
+    uint32_t counterAtEnd = 0;
+
+    ThreadPool tp;
+    TaskGraph graph;
+
+    TaskGraph::NodeID root = graph.AddTask([](ThreadPayload&) {});
+    std::vector<TaskGraph::NodeID> middle;
+    for (size_t i = 0; i < FAN_OUT_COUNT; ++i)
+    {
+        middle.push_back(graph.AddTask([&counter](ThreadPayload&) { counter++; }, { root }));
+    }
+    graph.AddTask([&](ThreadPayload&) { counterAtEnd = counter.load(); }, middle);
+
+    // graph can be executed multiple times
+    for (uint32_t run = 1; run <= 3; ++run)
+    {
+        ASSERT_TRUE(graph.Run(tp));
+        graph.Wait();
+        EXPECT_EQ(FAN_OUT_COUNT * run, counterAtEnd);
+    }
+}
+
+TEST(TaskGraph, Cycle)
+{
+    ThreadPool tp(2);
+    TaskGraph graph;
+
+    TaskGraph::NodeID a = graph.AddTask([](ThreadPayload&) {});
+    TaskGraph::NodeID b = graph.AddTask([](ThreadPayload&) {}, { a });
+    EXPECT_TRUE(graph.AddDependency(a, b));
+    EXPECT_FALSE(graph.AddDependency(a, a));
+    EXPECT_FALSE(graph.AddDependency(a, 42));
+
+    EXPECT_FALSE(graph.Run(tp));
+}
@@ -2,6 +2,12 @@
 
 #include <lkCommon/Utils/ThreadPool.hpp>
 
+#include <atomic>
+#include <string>
+#include <array>
+#include <set>
+#include <algorithm>
+
 using namespace lkCommon::Utils;
 
 const uint64_t TASK_COUNT_UNTIL_VALUE = 400'000'000;
@@ -219,3 +225,841 @@ TEST(ThreadPool, PayloadTest)
     EXPECT_EQ(PAYLOAD_CONST_VALUE_TO_ADD + 1, payload2);
     EXPECT_EQ(PAYLOAD_CONST_VALUE_TO_ADD + 2, payload3);
 }
+
+TEST(ThreadPool, ManySmallTasks)
+{
+    const uint32_t taskCount = 10000;
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp;
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tp.AddTask([&counter](ThreadPayload&) {
+            counter++;
+        });
+    }
+
+    tp.WaitForTasks();
+
+    EXPECT_EQ(taskCount, counter.load());
+}
+
+TEST(ThreadPool, AddTasksFromTask)
+{
+    const uint32_t taskCount = 100;
+    const uint32_t subtaskCount = 10;
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp(3);
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tp.AddTask([&tp, &counter, subtaskCount](ThreadPayload&) {
+            for (uint32_t j = 0; j < subtaskCount; ++j)
+            {
+                tp.AddTask([&counter](ThreadPayload&) {
+                    counter++;
+                });
+            }
+        });
+    }
+
+    tp.WaitForTasks();
+
+    EXPECT_EQ(taskCount * subtaskCount, counter.load());
+}
+
+TEST(ThreadPool, AddTasksBatch)
+{
+    const uint32_t taskCount = 4096;
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp;
+
+    std::vector<TaskCallback> tasks;
+    tasks.reserve(taskCount);
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tasks.emplace_back([&counter](ThreadPayload&) {
+            counter++;
+        });
+    }
+
+    tp.AddTasks(std::move(tasks));
+    tp.WaitForTasks();
+
+    EXPECT_EQ(taskCount, counter.load());
+}
+
+TEST(ThreadPool, AddTasksIndexed)
+{
+    const size_t taskCount = 4096;
+    std::vector<std::atomic<uint32_t>> hits(taskCount);
+    for (auto& h: hits)
+        h = 0;
+
+    ThreadPool tp(3);
+
+    tp.AddTasks(taskCount, [&hits](ThreadPayload&, size_t i) {
+        hits[i]++;
+    });
+    tp.WaitForTasks();
+
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        EXPECT_EQ(1u, hits[i].load());
+    }
+}
+
+TEST(ThreadPool, TaskGroupWait)
+{
+    const uint32_t taskCount = 100;
+    std::atomic<uint32_t> counter(0);
+    std::atomic<bool> releaseBlocker(false);
+
+    ThreadPool tp(2);
+    TaskGroup group;
+
+    // task outside of group which will not finish until we let it
+    tp.AddTask([&releaseBlocker](ThreadPayload&) {
+        while (!releaseBlocker.load())
+            std::this_thread::yield();
+    });
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tp.AddTask([&counter](ThreadPayload&) {
+            counter++;
+        }, group);
+    }
+
+    tp.WaitForTasks(group);
+    EXPECT_TRUE(group.IsDone());
+    EXPECT_EQ(taskCount, counter.load());
+
+    releaseBlocker = true;
+    tp.WaitForTasks();
+}
+
+TEST(ThreadPool, TaskGroupBatches)
+{
+    const size_t taskCount = 1000;
+    std::atomic<uint32_t> counterA(0);
+    std::atomic<uint32_t> counterB(0);
+
+    ThreadPool tp;
+    TaskGroup groupA;
+    TaskGroup groupB;
+
+    tp.AddTasks(taskCount, [&counterA](ThreadPayload&, size_t) {
+        counterA++;
+    }, groupA);
+
+    std::vector<TaskCallback> tasks;
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        tasks.emplace_back([&counterB](ThreadPayload&) {
+            counterB++;
+        });
+    }
+    tp.AddTasks(std::move(tasks), groupB);
+
+    tp.WaitForTasks(groupA);
+    EXPECT_EQ(taskCount, counterA.load());
+
+    tp.WaitForTasks(groupB);
+    EXPECT_EQ(taskCount, counterB.load());
+
+    // group can be reused
+    tp.AddTask([&counterA](ThreadPayload&) {
+        counterA++;
+    }, groupA);
+    tp.WaitForTasks(groupA);
+    EXPECT_EQ(taskCount + 1, counterA.load());
+}
+
+TEST(ThreadPool, TaskFuture)
+{
+    ThreadPool tp(3);
+
+    TaskFuture<uint32_t> future = tp.AddTask([](ThreadPayload&) -> uint32_t {
+        return PAYLOAD_CONST_VALUE_TO_ADD;
+    });
+
+    ASSERT_TRUE(future.IsValid());
+    EXPECT_EQ(PAYLOAD_CONST_VALUE_TO_ADD, future.Get());
+    EXPECT_TRUE(future.IsReady());
+}
+
+TEST(ThreadPool, TaskFutureMultiple)
+{
+    const uint32_t taskCount = 100;
+
+    ThreadPool tp;
+
+    std::vector<TaskFuture<std::string>> futures;
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        futures.push_back(tp.AddTask([i](ThreadPayload&) {
+            return std::to_string(i);
+        }));
+    }
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        EXPECT_EQ(std::to_string(i), futures[i].Get());
+    }
+}
+
+TEST(ThreadPool, TaskFutureReference)
+{
+    ThreadPool tp(2);
+
+    std::string text("referenced text");
+    TaskFuture<std::string> future = tp.AddTask([&text](ThreadPayload&) -> const std::string& {
+        return text;
+    });
+
+    // future holds a copy, so changing the original afterwards does not affect it
+    future.Wait();
+    text.clear();
+    EXPECT_EQ("referenced text", future.Get());
+}
+
+TEST(ThreadPool, TaskFutureDiscarded)
+{
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp(2);
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        // future is dropped right away, task should still execute safely
+        tp.AddTask([&counter](ThreadPayload&) {
+            return ++counter;
+        });
+    }
+
+    tp.WaitForTasks();
+    EXPECT_EQ(100u, counter.load());
+}
+
+TEST(ThreadPool, TaskInlineStorage)
+{
+    uint32_t result = 0;
+    ThreadPayload payload;
+
+    auto smallCallback = [&result](ThreadPayload&) {
+        result = PAYLOAD_CONST_VALUE_TO_ADD;
+    };
+    EXPECT_TRUE(Task::FitsInline<decltype(smallCallback)>());
+
+    Task task(smallCallback);
+    ASSERT_FALSE(task.IsEmpty());
+
+    Task movedTask(std::move(task));
+    EXPECT_TRUE(task.IsEmpty());
+    ASSERT_FALSE(movedTask.IsEmpty());
+
+    movedTask(payload);
+    EXPECT_EQ(PAYLOAD_CONST_VALUE_TO_ADD, result);
+
+    movedTask.Reset();
+    EXPECT_TRUE(movedTask.IsEmpty());
+}
+
+TEST(ThreadPool, TaskHeapStorage)
+{
+    std::array<uint32_t, 64> bigCapture;
+    bigCapture.fill(PAYLOAD_CONST_VALUE_TO_ADD);
+    uint32_t result = 0;
+    ThreadPayload payload;
+
+    auto bigCallback = [bigCapture, &result](ThreadPayload&) {
+        for (auto v: bigCapture)
+            result += v;
+    };
+    EXPECT_FALSE(Task::FitsInline<decltype(bigCallback)>());
+
+    Task task(bigCallback);
+    Task movedTask;
+    movedTask = std::move(task);
+    EXPECT_TRUE(task.IsEmpty());
+
+    movedTask(payload);
+    EXPECT_EQ(PAYLOAD_CONST_VALUE_TO_ADD * bigCapture.size(), result);
+}
+
+TEST(ThreadPool, TaskQueueGrow)
+{
+    const size_t initialCapacity = 4;
+    const size_t taskCount = 10;
+    std::vector<size_t> order;
+    ThreadPayload payload;
+
+    TaskQueue queue(initialCapacity);
+    ASSERT_EQ(initialCapacity, queue.Capacity());
+
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        queue.PushBack(Task([&order, i](ThreadPayload&) {
+            order.push_back(i);
+        }));
+    }
+
+    EXPECT_EQ(taskCount, queue.Size());
+    EXPECT_LE(taskCount, queue.Capacity());
+
+    Task task;
+    ASSERT_TRUE(queue.PopBack(task));
+    task(payload);
+    while (queue.PopFront(task))
+        task(payload);
+
+    EXPECT_TRUE(queue.IsEmpty());
+    ASSERT_EQ(taskCount, order.size());
+    EXPECT_EQ(taskCount - 1, order[0]);
+    for (size_t i = 1; i < taskCount; ++i)
+    {
+        EXPECT_EQ(i - 1, order[i]);
+    }
+}
+
+TEST(ThreadPool, AddTasksWithBigCaptures)
+{
+    const uint32_t taskCount = 100;
+    std::array<uint32_t, 64> bigCapture;
+    bigCapture.fill(1);
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp;
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tp.AddTask([bigCapture, &counter](ThreadPayload&) {
+            for (auto v: bigCapture)
+                counter += v;
+        });
+    }
+
+    tp.WaitForTasks();
+    EXPECT_EQ(taskCount * bigCapture.size(), counter.load());
+}
+
+TEST(ThreadPool, AffinityNone)
+{
+    ThreadPool tp(2, WorkerAffinity::NONE);
+
+    for (uint16_t i = 0; i < tp.GetWorkerThreadCount(); ++i)
+    {
+        EXPECT_EQ(Thread::NO_CPU, tp.GetWorkerThreadCPU(i));
+    }
+}
+
+TEST(ThreadPool, AffinityPhysicalCores)
+{
+    const uint32_t taskCount = 1000;
+    std::atomic<uint32_t> counter(0);
+    lkCommon::System::Info::CPUTopology topology = lkCommon::System::Info::GetCPUTopology();
+
+    ThreadPool tp(0, WorkerAffinity::PHYSICAL_CORES);
+
+    // first workers should occupy distinct physical cores
+    std::set<std::pair<uint32_t, uint32_t>> usedCores;
+    const size_t coreCount = lkCommon::System::Info::GetPhysicalCoreCount();
+    for (uint16_t i = 0; i < std::min(coreCount, tp.GetWorkerThreadCount()); ++i)
+    {
+        uint32_t cpu = tp.GetWorkerThreadCPU(i);
+        ASSERT_NE(Thread::NO_CPU, cpu);
+
+        for (const auto& c: topology)
+        {
+            if (c.id == cpu)
+            {
+                EXPECT_TRUE(usedCores.emplace(c.package, c.core).second);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tp.AddTask([&counter](ThreadPayload&) {
+            counter++;
+        });
+    }
+
+    tp.WaitForTasks();
+    EXPECT_EQ(taskCount, counter.load());
+}
+
+TEST(ThreadPool, AffinityNUMANodes)
+{
+    const uint32_t taskCount = 1000;
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp(lkCommon::System::Info::GetCPUCount() * 2, WorkerAffinity::NUMA_NODES);
+
+    for (uint16_t i = 0; i < tp.GetWorkerThreadCount(); ++i)
+    {
+        EXPECT_NE(Thread::NO_CPU, tp.GetWorkerThreadCPU(i));
+    }
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tp.AddTask([&counter](ThreadPayload&) {
+            counter++;
+        });
+    }
+
+    tp.WaitForTasks();
+    EXPECT_EQ(taskCount, counter.load());
+}
+
+TEST(ThreadPool, TaskPriorityOrder)
+{
+    std::atomic<bool> blockerStarted(false);
+    std::atomic<bool> releaseBlocker(false);
+    std::vector<TaskPriority> order;
+
+    ThreadPool tp(1);
+
+    // keep the only worker busy until all tasks are queued
+    tp.AddTask([&blockerStarted, &releaseBlocker](ThreadPayload&) {
+        blockerStarted = true;
+        while (!releaseBlocker.load())
+            std::this_thread::yield();
+    });
+
+    while (!blockerStarted.load())
+        std::this_thread::yield();
+
+    const TaskPriority priorities[] = {
+        TaskPriority::LOW, TaskPriority::NORMAL, TaskPriority::HIGH,
+        TaskPriority::NORMAL, TaskPriority::LOW, TaskPriority::HIGH,
+    };
+    for (TaskPriority p: priorities)
+    {
+        tp.AddTask([&order, p](ThreadPayload&) {
+            order.push_back(p);
+        }, p);
+    }
+
+    releaseBlocker = true;
+    tp.WaitForTasks();
+
+    ASSERT_EQ(6u, order.size());
+    EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+}
+
+TEST(ThreadPool, TaskPriorityAging)
+{
+    const uint32_t highTaskCount = ThreadPool::PRIORITY_AGING_LIMIT * 2;
+    std::atomic<bool> blockerStarted(false);
+    std::atomic<bool> releaseBlocker(false);
+    std::vector<TaskPriority> order;
+
+    ThreadPool tp(1);
+
+    tp.AddTask([&blockerStarted, &releaseBlocker](ThreadPayload&) {
+        blockerStarted = true;
+        while (!releaseBlocker.load())
+            std::this_thread::yield();
+    });
+
+    while (!blockerStarted.load())
+        std::this_thread::yield();
+
+    tp.AddTask([&order](ThreadPayload&) {
+        order.push_back(TaskPriority::LOW);
+    }, TaskPriority::LOW);
+    tp.AddTasks(highTaskCount, [&order](ThreadPayload&, size_t) {
+        order.push_back(TaskPriority::HIGH);
+    }, TaskPriority::HIGH);
+
+    releaseBlocker = true;
+    tp.WaitForTasks();
+
+    // low priority task cannot be passed over more than aging limit allows
+    ASSERT_EQ(highTaskCount + 1, order.size());
+    auto lowTask = std::find(order.begin(), order.end(), TaskPriority::LOW);
+    EXPECT_EQ(ThreadPool::PRIORITY_AGING_LIMIT, static_cast<uint32_t>(lowTask - order.begin()));
+}
+
+TEST(ThreadPool, WaitForTasksHelping)
+{
+    std::atomic<bool> blockerStarted(false);
+    std::atomic<bool> releaseBlocker(false);
+    std::atomic<uint16_t> releaserTid(0);
+
+    ThreadPool tp(1);
+
+    // the only worker is blocked until some other thread runs next task
+    tp.AddTask([&blockerStarted, &releaseBlocker](ThreadPayload&) {
+        blockerStarted = true;
+        while (!releaseBlocker.load())
+            std::this_thread::yield();
+    });
+
+    while (!blockerStarted.load())
+        std::this_thread::yield();
+
+    tp.AddTask([&releaseBlocker, &releaserTid](ThreadPayload& payload) {
+        releaserTid = payload.tid;
+        releaseBlocker = true;
+    });
+
+    ThreadPayload mainPayload;
+    mainPayload.tid = 1234;
+    tp.WaitForTasks(mainPayload);
+
+    EXPECT_TRUE(releaseBlocker.load());
+    EXPECT_EQ(1234, releaserTid.load());
+}
+
+TEST(ThreadPool, WaitForGroupInsideTask)
+{
+    const uint32_t taskCount = 100;
+    std::atomic<uint32_t> counter(0);
+    std::atomic<bool> subtasksDone(false);
+
+    // single worker would deadlock if it blocked waiting for its subtasks
+    ThreadPool tp(1);
+
+    tp.AddTask([&tp, &counter, &subtasksDone, taskCount](ThreadPayload&) {
+        TaskGroup group;
+        for (uint32_t i = 0; i < taskCount; ++i)
+        {
+            tp.AddTask([&counter](ThreadPayload&) {
+                counter++;
+            }, group);
+        }
+
+        tp.WaitForTasks(group);
+        subtasksDone = (counter.load() == taskCount);
+    });
+
+    tp.WaitForTasks();
+    EXPECT_TRUE(subtasksDone.load());
+    EXPECT_EQ(taskCount, counter.load());
+}
+
+TEST(ThreadPool, TaskFutureInsideTask)
+{
+    ThreadPool tp(2);
+
+    TaskFuture<uint32_t> outer = tp.AddTask([&tp](ThreadPayload&) -> uint32_t {
+        std::vector<TaskFuture<uint32_t>> inner;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            inner.push_back(tp.AddTask([i](ThreadPayload&) -> uint32_t {
+                return i;
+            }));
+        }
+
+        uint32_t sum = 0;
+        for (auto& f: inner)
+        {
+            sum += f.Get();
+        }
+        return sum;
+    });
+
+    EXPECT_EQ(120u, outer.Get());
+}
+
+TEST(ThreadPool, WaitForTasksInsideTask)
+{
+    const uint32_t taskCount = 100;
+    std::atomic<uint32_t> counter(0);
+    std::atomic<uint32_t> counterAfterWait(0);
+
+    ThreadPool tp(2);
+
+    // both workers wait from inside a task, none of them can block the other
+    for (uint32_t t = 0; t < 2; ++t)
+    {
+        tp.AddTask([&tp, &counter, &counterAfterWait, taskCount](ThreadPayload&) {
+            for (uint32_t i = 0; i < taskCount; ++i)
+            {
+                tp.AddTask([&counter](ThreadPayload&) {
+                    counter++;
+                });
+            }
+
+            tp.WaitForTasks();
+            counterAfterWait += counter.load();
+        });
+    }
+
+    tp.WaitForTasks();
+    EXPECT_EQ(taskCount * 2, counter.load());
+    EXPECT_LE(taskCount * 2, counterAfterWait.load());
+}
+
+TEST(ThreadPool, AddTasksFromManyThreads)
+{
+    const uint32_t threadCount = 4;
+    const uint32_t taskCount = 5000;
+    std::atomic<uint32_t> counter(0);
+    std::atomic<bool> release(false);
+
+    ThreadPool tp(2);
+
+    // block workers, so external tasks pile up past submission queue's
+    // capacity and have to spill over to workers' deques
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        tp.AddTask([&release](ThreadPayload&) {
+            while (!release.load())
+            {
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    std::vector<std::thread> producers;
+    for (uint32_t t = 0; t < threadCount; ++t)
+    {
+        producers.emplace_back([&tp, &counter]() {
+            for (uint32_t i = 0; i < taskCount; ++i)
+            {
+                tp.AddTask([&counter](ThreadPayload&) {
+                    counter++;
+                }, static_cast<TaskPriority>(i % TASK_PRIORITY_COUNT));
+            }
+        });
+    }
+
+    for (auto& p: producers)
+    {
+        p.join();
+    }
+
+    release = true;
+    tp.WaitForTasks();
+    EXPECT_EQ(threadCount * taskCount, counter.load());
+}
+
+TEST(ThreadPool, WorkerIdlePolicy)
+{
+    const uint32_t taskCount = 1000;
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp(2);
+
+    WorkerIdlePolicy defaultPolicy = tp.GetWorkerIdlePolicy();
+    EXPECT_EQ(WorkerIdlePolicy::DEFAULT_SPIN_COUNT, defaultPolicy.spinCount);
+    EXPECT_EQ(WorkerIdlePolicy::DEFAULT_YIELD_COUNT, defaultPolicy.yieldCount);
+
+    const WorkerIdlePolicy policies[] = {
+        WorkerIdlePolicy(0, 0),
+        WorkerIdlePolicy(0, 100),
+        WorkerIdlePolicy(100000, 0),
+    };
+    for (const WorkerIdlePolicy& policy: policies)
+    {
+        tp.SetWorkerIdlePolicy(policy);
+        EXPECT_EQ(policy.spinCount, tp.GetWorkerIdlePolicy().spinCount);
+        EXPECT_EQ(policy.yieldCount, tp.GetWorkerIdlePolicy().yieldCount);
+
+        // submit in small bursts, so workers keep going idle in between
+        counter = 0;
+        for (uint32_t i = 0; i < taskCount; ++i)
+        {
+            tp.AddTask([&counter](ThreadPayload&) {
+                counter++;
+            });
+
+            if (i % 10 == 0)
+            {
+                tp.WaitForTasks();
+            }
+        }
+
+        tp.WaitForTasks();
+        EXPECT_EQ(taskCount, counter.load());
+    }
+}
+
+TEST(ThreadPool, SetWorkerThreadCount)
+{
+    ThreadPool tp(2);
+    EXPECT_EQ(2u, tp.GetWorkerThreadCount());
+
+    EXPECT_TRUE(tp.SetWorkerThreadCount(6));
+    EXPECT_EQ(6u, tp.GetWorkerThreadCount());
+
+    EXPECT_TRUE(tp.SetWorkerThreadCount(1));
+    EXPECT_EQ(1u, tp.GetWorkerThreadCount());
+
+    EXPECT_TRUE(tp.SetWorkerThreadCount(0));
+    EXPECT_EQ(lkCommon::System::Info::GetCPUCount(), tp.GetWorkerThreadCount());
+
+    // only remaining worker runs tasks after shrinking
+    EXPECT_TRUE(tp.SetWorkerThreadCount(1));
+    std::atomic<uint32_t> foreignTids(0);
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        tp.AddTask([&foreignTids](ThreadPayload& payload) {
+            if (payload.tid != 0)
+                foreignTids++;
+        });
+    }
+
+    tp.WaitForTasks();
+    EXPECT_EQ(0u, foreignTids.load());
+}
+
+TEST(ThreadPool, SetWorkerThreadCountWhileRunning)
+{
+    const uint32_t taskCount = 20000;
+    std::atomic<uint32_t> counter(0);
+
+    ThreadPool tp(4);
+
+    // keep resizing while tasks are being added and executed - none of them
+    // can be lost
+    std::thread resizer([&tp]() {
+        const size_t counts[] = { 1, 8, 2, 5, 3 };
+        for (uint32_t i = 0; i < 20; ++i)
+        {
+            EXPECT_TRUE(tp.SetWorkerThreadCount(counts[i % 5]));
+        }
+    });
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        tp.AddTask([&counter](ThreadPayload&) {
+            counter++;
+        });
+    }
+
+    resizer.join();
+    tp.WaitForTasks();
+    EXPECT_EQ(taskCount, counter.load());
+    EXPECT_EQ(3u, tp.GetWorkerThreadCount());
+}
+
+TEST(ThreadPool, SetWorkerThreadCountInsideTask)
+{
+    std::atomic<bool> result(true);
+
+    ThreadPool tp(2);
+    tp.AddTask([&tp, &result](ThreadPayload&) {
+        result = tp.SetWorkerThreadCount(4);
+    });
+
+    tp.WaitForTasks();
+    EXPECT_FALSE(result.load());
+    EXPECT_EQ(2u, tp.GetWorkerThreadCount());
+}
+
+TEST(ThreadPool, StatisticsDisabled)
+{
+    ThreadPool tp(2);
+    EXPECT_FALSE(tp.IsStatisticsEnabled());
+
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        tp.AddTask([](ThreadPayload&) {});
+    }
+    tp.WaitForTasks();
+
+    ThreadPoolStatistics stats = tp.GetStatistics();
+    EXPECT_EQ(0u, stats.tasksSubmitted);
+    EXPECT_EQ(0u, stats.tasksCompleted);
+    EXPECT_EQ(0u, stats.runTime.count);
+    EXPECT_EQ(2u, stats.workers.size());
+}
+
+TEST(ThreadPool, Statistics)
+{
+    const uint32_t taskCount = 200;
+    const uint32_t workerCount = 4;
+
+    ThreadPool tp(workerCount);
+    tp.EnableStatistics(true);
+    EXPECT_TRUE(tp.IsStatisticsEnabled());
+
+    for (uint32_t i = 0; i < taskCount / 2; ++i)
+    {
+        tp.AddTask([](ThreadPayload&) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        });
+    }
+    tp.AddTasks(taskCount / 2, [](ThreadPayload&, size_t) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    });
+    tp.WaitForTasks();
+
+    ThreadPoolStatistics stats = tp.GetStatistics();
+    EXPECT_EQ(taskCount, stats.tasksSubmitted);
+    EXPECT_EQ(taskCount, stats.tasksCompleted);
+    EXPECT_LE(1u, stats.queueHighWaterMark);
+    EXPECT_GE(taskCount, stats.queueHighWaterMark);
+    EXPECT_EQ(taskCount, stats.queueLatency.count);
+    EXPECT_EQ(taskCount, stats.runTime.count);
+    EXPECT_LE(100'000u, stats.runTime.GetAverageNanoseconds());
+    EXPECT_LE(100'000u, stats.runTime.maxNanoseconds);
+    EXPECT_LE(100u, stats.runTime.GetPercentile(50.0));
+
+    uint64_t executed = 0;
+    uint64_t histogramCount = 0;
+    ASSERT_EQ(workerCount, stats.workers.size());
+    for (const WorkerStatistics& w: stats.workers)
+    {
+        executed += w.tasksExecuted;
+        EXPECT_GE(1.0, w.GetUtilization());
+        EXPECT_LE(0.0, w.GetUtilization());
+    }
+    for (uint64_t bucket: stats.runTime.buckets)
+    {
+        histogramCount += bucket;
+    }
+    EXPECT_EQ(taskCount, executed);
+    EXPECT_EQ(taskCount, histogramCount);
+
+    tp.ResetStatistics();
+    stats = tp.GetStatistics();
+    EXPECT_EQ(0u, stats.tasksSubmitted);
+    EXPECT_EQ(0u, stats.tasksCompleted);
+    EXPECT_EQ(0u, stats.queueHighWaterMark);
+    EXPECT_EQ(0u, stats.runTime.count);
+}
+
+TEST(ThreadPool, StatisticsIdleDroppedWhenDisabled)
+{
+    ThreadPool tp(2);
+    tp.EnableStatistics(true);
+
+    tp.AddTask([](ThreadPayload&) {});
+    tp.WaitForTasks();
+
+    // let workers go idle, then stop counting
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    tp.EnableStatistics(false);
+    tp.ResetStatistics();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ThreadPoolStatistics stats = tp.GetStatistics();
+    ASSERT_EQ(2u, stats.workers.size());
+    for (const WorkerStatistics& w: stats.workers)
+    {
+        EXPECT_EQ(0u, w.idleNanoseconds);
+    }
+}
+
+TEST(ThreadPool, StatisticsHistogramBuckets)
+{
+    EXPECT_EQ(0u, DurationHistogram::GetBucket(0));
+    EXPECT_EQ(0u, DurationHistogram::GetBucket(999));
+    EXPECT_EQ(1u, DurationHistogram::GetBucket(1'000));
+    EXPECT_EQ(2u, DurationHistogram::GetBucket(2'000));
+    EXPECT_EQ(2u, DurationHistogram::GetBucket(3'999));
+    EXPECT_EQ(3u, DurationHistogram::GetBucket(4'000));
+    EXPECT_EQ(DurationHistogram::BUCKET_COUNT - 1, DurationHistogram::GetBucket(std::numeric_limits<uint64_t>::max()));
+
+    EXPECT_EQ(1u, DurationHistogram::GetBucketUpperBound(0));
+    EXPECT_EQ(4u, DurationHistogram::GetBucketUpperBound(2));
+}